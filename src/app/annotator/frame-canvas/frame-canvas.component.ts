@@ -58,6 +58,10 @@ export class FrameCanvasComponent implements OnInit, OnDestroy {
         return this.images.length;
     }
 
+    // Frames served from a video are loaded as they are viewed, keeping only the most recently viewed ones.
+    private readonly frameWindow: number = 16;
+    private loadedFrames: Array<number> = [];
+
     private _viewer;
     get viewer() {
         return this._viewer;
@@ -299,23 +303,32 @@ export class FrameCanvasComponent implements OnInit, OnDestroy {
         if (is.number(frameNumber)) {
             let index = frameNumber - 1;
 
-            this.layers.image.activate();
-			
-            let center = new paper.Point(
-                this.images[index].naturalWidth / 2,
-                this.images[index].naturalHeight / 2
-            );
+            this.loadFrame(index).then((image) => {
+                // A later frame change may have finished loading first.
+                if (index !== this.ws.annotation.currentFrameIndex) {
+                    return;
+                }
 
-            if (!this.layers.image.firstChild) {
-                let raster = new paper.Raster(this.images[index].src);
-                raster.position = center;
-            }
-            else {
-                let raster = (this.layers.image.firstChild as paper.Raster);
-                raster.source = this.images[index].src;
-            }
+                this.layers.image.activate();
+
+                let center = new paper.Point(
+                    image.naturalWidth / 2,
+                    image.naturalHeight / 2
+                );
 
-            this.drawVisuals(frameNumber);
+                if (!this.layers.image.firstChild) {
+                    let raster = new paper.Raster(image.src);
+                    raster.position = center;
+                }
+                else {
+                    let raster = (this.layers.image.firstChild as paper.Raster);
+                    raster.source = image.src;
+                }
+
+                this.drawVisuals(frameNumber);
+            }, (err) => {
+                console.error(err);
+            });
         }
     }
 
@@ -781,6 +794,75 @@ export class FrameCanvasComponent implements OnInit, OnDestroy {
         });
     }
 
+    /**
+     * Gets the image of a frame, decoding it from the workspace video first when frames are served on demand.
+     */
+    private loadFrame(index: number): Q.Promise<HTMLImageElement> {
+        let loaded = this.loadedFrames.indexOf(index);
+        if (loaded >= 0) {
+            this.loadedFrames.splice(loaded, 1);
+            this.loadedFrames.push(index);
+        }
+
+        if (this.images[index] || !this.ws.serveFrames) {
+            return this.images[index] ? Q(this.images[index]) : Q.reject<HTMLImageElement>('No image for frame ' + (index + 1) + '.');
+        }
+
+        return this.its.getFrame(this.ws.videoFile, index).then((data) => {
+            let deferred: Q.Deferred<HTMLImageElement> = Q.defer<HTMLImageElement>();
+            let image = new Image();
+
+            image.onload = () => {
+                deferred.resolve(image);
+            };
+            image.onerror = (err) => {
+                URL.revokeObjectURL(image.src);
+                deferred.reject(err);
+            };
+            image.src = URL.createObjectURL(new Blob([data], { 'type': 'image/jpeg' }));
+
+            return deferred.promise;
+        }).then((image) => {
+            if (!this.images) {
+                URL.revokeObjectURL(image.src);
+                return image;
+            }
+
+            // The frame may have been loaded by an overlapping request.
+            if (this.images[index]) {
+                URL.revokeObjectURL(image.src);
+                return this.images[index];
+            }
+
+            this.images[index] = image;
+            this.loadedFrames.push(index);
+
+            while (this.loadedFrames.length > this.frameWindow) {
+                this.unloadFrame(this.loadedFrames.shift());
+            }
+
+            return image;
+        });
+    }
+
+    private unloadFrame(index: number) {
+        if (this.images && this.images[index]) {
+            URL.revokeObjectURL(this.images[index].src);
+            this.images[index] = undefined;
+        }
+    }
+
+    private loadVideoFrames(filenames: Array<string>): Q.Promise<{}> {
+        this.loadedFrames.splice(0).forEach((index) => {
+            this.unloadFrame(index);
+        });
+
+        // Only the first frame is decoded up front, the rest as they are viewed.
+        this.images = new Array(filenames.length);
+
+        return filenames.length > 0 ? this.loadFrame(0) : Q({});
+    }
+
     private loadImages(dir: string, filenames: Array<string>): Q.Promise<{}> {
         let promises: Array<Q.Promise<{}>> = [];
 
@@ -816,7 +898,8 @@ export class FrameCanvasComponent implements OnInit, OnDestroy {
             
             this.ws.annotation.imagesObs.subscribe(
                 (imageList) => {
-                    imagesLoaded = this.loadImages(this.ws.workspaceDir, imageList);
+                    imagesLoaded = this.ws.serveFrames ?
+                        this.loadVideoFrames(imageList) : this.loadImages(this.ws.workspaceDir, imageList);
                     imagesLoaded.done(() => {
                         // TODO: Move loading resolver elsewhere 
                         Loader.finish();
@@ -863,6 +946,9 @@ export class FrameCanvasComponent implements OnInit, OnDestroy {
     public ngOnDestroy() {
         if (this.ws.initialised) {
             // Memory management to remove references to unused objects.
+            this.loadedFrames.splice(0).forEach((index) => {
+                this.unloadFrame(index);
+            });
             this.images = null;
 
             paper.view.off('mousemove');
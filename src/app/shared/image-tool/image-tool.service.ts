@@ -6,6 +6,7 @@ import * as fs from 'fs';
 import * as ChildProcess from 'child_process';
 import * as path from 'path';
 import * as Q from 'q';
+import * as is from 'is';
 
 /**
  * This class provides the shared camera-tool interface so that it can be initialised and used in the annotator.
@@ -13,19 +14,88 @@ import * as Q from 'q';
 @Injectable()
 export class ImageToolService {
     private cameraToolPath: string = path.join(__dirname, 'native', 'CameraTool');
+    private server: ChildProcess.ChildProcess = null;
+    private serverBuffer: Buffer = Buffer.alloc(0);
+    private serverQueue: Array<Q.Deferred<any>> = [];
 
     constructor() {
     }
 
-    public extractImages(src: string, dst: string) {
-        return Q.denodeify(ChildProcess.execFile)(
-            this.cameraToolPath,
-            [
-                '-E',
-                src,
-                dst
-            ]
-        );
+    /**
+     * Starts a persistent CameraTool process in serve mode. Responses arrive in request order, one JSON line each,
+     * with frame responses followed by `size` bytes of image data which are attached as `data`.
+     */
+    private startServer() {
+        let server = ChildProcess.spawn(this.cameraToolPath, ['--serve']);
+        let stop = (error: Error) => {
+            if (this.server === server) {
+                this.server = null;
+                this.serverQueue.splice(0).forEach((deferred) => {
+                    deferred.reject(error);
+                });
+            }
+        };
+
+        this.server = server;
+        this.serverBuffer = Buffer.alloc(0);
+
+        server.stdout.on('data', (data: Buffer) => {
+            this.serverBuffer = Buffer.concat([this.serverBuffer, data]);
+
+            while (true) {
+                let newline = this.serverBuffer.indexOf('\n');
+                if (newline < 0) {
+                    break;
+                }
+
+                let response;
+                try {
+                    response = JSON.parse(this.serverBuffer.toString('utf8', 0, newline));
+                }
+                catch (e) {
+                    response = { error: e.message };
+                }
+
+                let size = is.number(response.size) ? response.size : 0;
+                if (this.serverBuffer.length < newline + 1 + size) {
+                    break;
+                }
+
+                if (size > 0) {
+                    response.data = this.serverBuffer.slice(newline + 1, newline + 1 + size);
+                }
+                this.serverBuffer = this.serverBuffer.slice(newline + 1 + size);
+
+                let deferred = this.serverQueue.shift();
+                if (deferred) {
+                    if (response.error) {
+                        deferred.reject(new Error(response.error));
+                    }
+                    else {
+                        deferred.resolve(response);
+                    }
+                }
+            }
+        });
+        server.on('error', (error: Error) => {
+            stop(error);
+        });
+        server.on('exit', () => {
+            stop(new Error('CameraTool server exited.'));
+        });
+    }
+
+    private request(query: Object) {
+        let deferred = Q.defer<any>();
+
+        if (!this.server) {
+            this.startServer();
+        }
+
+        this.serverQueue.push(deferred);
+        this.server.stdin.write(JSON.stringify(query) + '\n');
+
+        return deferred.promise;
     }
 
     public readImageDir(src: string) {
@@ -42,21 +112,46 @@ export class ImageToolService {
         });
     }
 
+    /**
+     * Gets the frame count and frame rate of a video, for serving frames without extracting them.
+     */
+    public getVideoInfo(video: string) {
+        return this.request({
+            type: 'videoInfo',
+            video: path.normalize(video)
+        }).then((data) => {
+            return { frames: data.frames as number, fps: data.fps as number };
+        });
+    }
+
+    /**
+     * Decodes a single frame of a video on demand.
+     * @param index Zero based frame index.
+     * @returns JPEG encoded frame.
+     */
+    public getFrame(video: string, index: number) {
+        return this.request({
+            type: 'frame',
+            video: path.normalize(video),
+            index: index
+        }).then((data) => {
+            return data.data as Buffer;
+        });
+    }
+
     public getRealCoordinates(
         point: IPoint,
         origin: IPoint,
         lCalibFile: string, pCalibFile: string
     ) {
-        return Q.denodeify(ChildProcess.execFile)(
-            this.cameraToolPath,
-            [
-                '-Ip',
-                point.x.toString(), point.y.toString(),
-                origin.x.toString(), origin.y.toString(),
-                path.normalize(lCalibFile), path.normalize(pCalibFile)
-            ]
-        ).then((data) => {
-            return JSON.parse((data as Array<string>)[0]) as IPoint;
+        return this.request({
+            type: 'point',
+            x: point.x, y: point.y,
+            originX: origin.x, originY: origin.y,
+            lens: path.normalize(lCalibFile),
+            perspective: path.normalize(pCalibFile)
+        }).then((data) => {
+            return data as IPoint;
         });
     }
 }
@@ -27,6 +27,7 @@ export interface IWorkspaceVars {
     'video': {
         'increment': string;
         'camera': number;
+        'file'?: string;
     };
     'lensCalibrationFile': string;
     'perspectiveCalibrationFile': string;
@@ -60,6 +61,8 @@ export class WorkspaceService {
 
     // Inputs
     public videoFile: string;
+    // Frames are decoded from videoFile on demand instead of read from extracted images.
+    public serveFrames: boolean = false;
     public annotationFile: string;
     public workspaceDir: string;
 
@@ -228,6 +231,7 @@ export class WorkspaceService {
 
         // Load fresh annotation
         this.annotation = new Annotation();
+        this.serveFrames = false;
 
         let promiseChain: Q.Promise<any>;
 
@@ -260,6 +264,21 @@ export class WorkspaceService {
             return deferred.promise;
         }
 
+        let readInVideoFrames = () => {
+            return this.its.getVideoInfo(this.videoFile).then((info) => {
+                if (info.frames <= 0) {
+                    return Q.reject('No frames in video.');
+                }
+
+                // Named as extracted frames would be, so frame names display the same.
+                let frames: Array<string> = [];
+                for (let i = 1; i <= info.frames; i++) {
+                    frames.push(i + '.jpg');
+                }
+                return frames;
+            });
+        }
+
         let readInImageSrcs = () => {
             return this.its.readImageDir(this.workspaceDir).then((imageSrcs) => {
                 if (imageSrcs.length === 0) {
@@ -272,26 +291,38 @@ export class WorkspaceService {
         if (this.videoFile) {
             // Get context from input video
             this.getVideoContext();
+            this.serveFrames = true;
 
             // Write workspace
             this.toFile(path.join(this.workspaceDir, 'workspace.json'));
 
-            // If there's a video file, extract the images and read in image paths
+            // If there's a video file, frames are served from it as they are viewed
             promiseChain = Q.all([
-                this.its.extractImages(this.videoFile, this.workspaceDir)
-                    .then(readInImageSrcs)
+                readInVideoFrames()
                     .then(setAnnotationImages),
                 getVideoAnnotations()
             ]);
         }
         else {
-            // Otherwise just read in image paths and the workspace file
-            promiseChain = Q.all([
-                readInImageSrcs()
-                    .then(setAnnotationImages),
-                this.fromFile(path.join(this.workspaceDir, 'workspace.json'))
-                    .then(getVideoAnnotations),
-            ]);
+            // Otherwise read the workspace file, and serve frames from the video it was created from, or read
+            // in the image paths of workspaces with extracted images.
+            promiseChain = this.fromFile(path.join(this.workspaceDir, 'workspace.json')).then((workspaceVars) => {
+                if (workspaceVars && workspaceVars.video && workspaceVars.video.file) {
+                    this.videoFile = path.normalize(workspaceVars.video.file);
+                    this.serveFrames = true;
+                    return Q.all([
+                        readInVideoFrames()
+                            .then(setAnnotationImages),
+                        getVideoAnnotations(workspaceVars)
+                    ]);
+                }
+
+                return Q.all([
+                    readInImageSrcs()
+                        .then(setAnnotationImages),
+                    getVideoAnnotations(workspaceVars)
+                ]);
+            });
         }
 
         promiseChain.then(fillAnnotationFrames);
@@ -331,7 +362,8 @@ export class WorkspaceService {
                 },
                 'video': {
                     'increment': this.annotation.data.increment,
-                    'camera': this.annotation.data.camera
+                    'camera': this.annotation.data.camera,
+                    'file': this.serveFrames ? this.videoFile : undefined
                 },
                 'lensCalibrationFile': this.calibration.lensCalibrationFile,
                 'perspectiveCalibrationFile': this.calibration.perspectiveCalibrationFile,
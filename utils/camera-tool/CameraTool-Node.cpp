@@ -1,5 +1,5 @@
 #include <nan.h>
-#include "ICameraTool.hpp"
+#include "./node-interface/ICameraTool.hpp"
 
 void Init(v8::Local<v8::Object> exports, v8::Local<v8::Object> module) {
   ICameraTool::Init(exports, module);
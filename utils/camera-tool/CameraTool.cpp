@@ -12,15 +12,34 @@
 #include "./includes/LensCalibration.hpp"
 #include "./includes/PerspectiveCalibration.hpp"
 #include "./includes/ImageDistance.hpp"
+#include "./includes/FrameExtractor.hpp"
+#include "./includes/FrameServer.hpp"
+#include "./includes/ImageRectifier.hpp"
+#include "./includes/ImageFiles.hpp"
+#include "./includes/DeepZoom.hpp"
+#include "./includes/CalibrationFile.hpp"
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/videoio.hpp>
+#include <opencv2/calib3d.hpp>
 
 #include <sstream>
 #include <string>
 #include <iostream>
 #include <memory>
+#include <map>
+#include <ctime>
+#include <cctype>
+#include <stdexcept>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 using namespace std;
 using namespace cv;
@@ -33,59 +52,224 @@ using namespace cv;
  */
 void extractImages(string src, string dst)
 {
-    VideoCapture video(src);
-    if (video.isOpened())
+    FrameExtractor extractor;
+
+    // The frame rate is reported whenever the video opened, even if some
+    // frames failed to write.
+    if (extractor.extract(src, dst) || extractor.getFrameCount() > 0)
     {
-        Mat frame;
-        int frameCount = 0;
+        cout << "{\"fps\":" << extractor.getFps() << "}";
+    }
+}
 
-		auto fps = video.get(CAP_PROP_FPS);
+/**
+ * Applies the frame selection options shared by the lens calibration options.
+ * @param lCalib          Calibration to configure.
+ * @param stride          Search every stride-th frame.
+ * @param minDisplacement Minimum mean corner movement in pixels between
+ *                        accepted frames.
+ * @param minSharpness    Skip frames less sharp than this, 0 searches all.
+ * @return                False if the options are out of range.
+ */
+bool configureSampling(LensCalibration& lCalib, string stride, string minDisplacement, string minSharpness)
+{
+    // Seeking lands on keyframes, so it only beats grabbing for large strides.
+    const int seekStride = 30;
 
-        if
-        (
-            dst.substr(dst.length() - 1, 1) != "/" ||
-            dst.substr(dst.length() - 1, 1) != "\\"
-        )
-        {
-            dst += "/";
-        }
+    int step = stoi(stride);
 
-        while(true)
-        {
-            video >> frame;
-            if (!frame.empty())
-            {
-                frameCount++;
+    if (step < 1)
+    {
+        cout << "Stride must be at least 1: " << stride << endl;
+        return false;
+    }
 
-                string filename = to_string(frameCount);
-                imwrite(dst + filename + ".jpg", frame);
-            }
-            else
-            {
-                break;
-            }
-        }
+    lCalib.setSampling((unsigned int) step, step >= seekStride, stod(minDisplacement));
+    lCalib.setMinSharpness(stod(minSharpness));
 
-        cout << "{\"fps\":" << fps << "}";
-    }
+    return true;
 }
 
 /**
  * Performs lens calibration using OpenCV on a calibration video and saves a
  * calibration file.
- * @param src    Source video.
- * @param dst    Destination markup file (.xml or .yaml extension required).
- * @param frames Number of valid calibration frames (Don't use over 50).
+ * @param src             Source video.
+ * @param dst             Destination markup file (.xml or .yaml extension required).
+ * @param frames          Number of valid calibration frames (Don't use over 50).
+ * @param stride          Search every stride-th frame.
+ * @param minDisplacement Minimum mean corner movement in pixels between
+ *                        accepted frames.
+ * @param minSharpness    Skip frames less sharp than this, 0 searches all.
  */
-void lensCalibrationF(string src, string dst, string frames)
+void lensCalibrationF(string src, string dst, string frames, string stride = "1", string minDisplacement = "0", string minSharpness = "0")
 {
     LensCalibration lCalib;
+
+    if (!configureSampling(lCalib, stride, minDisplacement, minSharpness))
+    {
+        return;
+    }
+
+    lCalib.setDetectionCache(src + ".corners");
+
     if (lCalib.fromVideo(src, (size_t) stoi(frames)))
     {
         lCalib.store(dst);
     }
 }
 
+/**
+ * Performs lens calibration on still images of the checkerboard pattern and
+ * saves a calibration file. JSON output gives the reprojection error.
+ * @param src             Source directory or glob pattern.
+ * @param dst             Destination calibration file.
+ * @param frames          Number of valid images to use, 0 uses all.
+ * @param minDisplacement Minimum mean corner movement in pixels between
+ *                        accepted images.
+ * @param minSharpness    Skip images less sharp than this, 0 searches all.
+ */
+void lensCalibrationD(string src, string dst, string frames = "0", string minDisplacement = "0", string minSharpness = "0")
+{
+    LensCalibration lCalib;
+
+    if (!configureSampling(lCalib, "1", minDisplacement, minSharpness))
+    {
+        return;
+    }
+
+    if (lCalib.fromImages(src, (size_t) stoi(frames)) && lCalib.store(dst))
+    {
+        cout << "{\"error\":" << lCalib.getReprojectionError() << "}";
+    }
+}
+
+/**
+ * Parses a comma separated list of calibrateCamera flag names, such as
+ * "fix_k4,fix_k5", into OpenCV flags. A number is taken as the flags value.
+ * @param  flags Flag list.
+ * @return       OpenCV flags, -1 if a name is not recognised.
+ */
+int parseCalibrationFlags(const string& flags)
+{
+    static const map<string, int> names = {
+        { "fix_principal_point", CALIB_FIX_PRINCIPAL_POINT },
+        { "fix_aspect_ratio", CALIB_FIX_ASPECT_RATIO },
+        { "fix_focal_length", CALIB_FIX_FOCAL_LENGTH },
+        { "zero_tangent_dist", CALIB_ZERO_TANGENT_DIST },
+        { "fix_k1", CALIB_FIX_K1 },
+        { "fix_k2", CALIB_FIX_K2 },
+        { "fix_k3", CALIB_FIX_K3 },
+        { "fix_k4", CALIB_FIX_K4 },
+        { "fix_k5", CALIB_FIX_K5 },
+        { "fix_k6", CALIB_FIX_K6 },
+        { "rational_model", CALIB_RATIONAL_MODEL }
+    };
+
+    if (!flags.empty() && isdigit((unsigned char) flags[0]))
+    {
+        return stoi(flags);
+    }
+
+    int value = 0;
+    stringstream list(flags);
+    string name;
+
+    while (getline(list, name, ','))
+    {
+        if (name.empty() || name == "none")
+        {
+            continue;
+        }
+
+        auto it = names.find(name);
+
+        if (it == names.end())
+        {
+            return -1;
+        }
+
+        value |= it->second;
+    }
+
+    return value;
+}
+
+/**
+ * Performs lens calibration on a calibration video with the given
+ * calibrateCamera flags. The pattern corners are cached next to the video, so
+ * trying other flags on the same video only repeats the solve. JSON output
+ * gives the reprojection error.
+ * @param src             Source video.
+ * @param dst             Destination calibration file.
+ * @param frames          Number of valid calibration frames.
+ * @param flags           Comma separated calibrateCamera flag names.
+ * @param stride          Search every stride-th frame.
+ * @param minDisplacement Minimum mean corner movement in pixels between
+ *                        accepted frames.
+ * @param minSharpness    Skip frames less sharp than this, 0 searches all.
+ */
+void lensCalibrationT(string src, string dst, string frames, string flags, string stride = "1", string minDisplacement = "0", string minSharpness = "0")
+{
+    int calibFlags = parseCalibrationFlags(flags);
+
+    if (calibFlags < 0)
+    {
+        cout << "Unknown calibration flags: " << flags << endl;
+        return;
+    }
+
+    // There is no calibration to take an intrinsic guess from, -Lu refines
+    // an existing calibration instead.
+    if (calibFlags & CALIB_USE_INTRINSIC_GUESS)
+    {
+        cout << "An intrinsic guess needs an existing calibration, use -Lu." << endl;
+        return;
+    }
+
+    LensCalibration lCalib;
+
+    if (!configureSampling(lCalib, stride, minDisplacement, minSharpness))
+    {
+        return;
+    }
+
+    lCalib.setDetectionCache(src + ".corners");
+    lCalib.setCalibrationFlags(calibFlags);
+
+    if (lCalib.fromVideo(src, (size_t) stoi(frames)) && lCalib.store(dst))
+    {
+        cout << "{\"error\":" << lCalib.getReprojectionError() << "}";
+    }
+}
+
+/**
+ * Refines an existing lens calibration with a new calibration video, seeding
+ * the solver with the existing intrinsics and stopping once the reprojection
+ * error converges. JSON output gives the final reprojection error.
+ * @param src             Source video.
+ * @param calibFile       Existing calibration file.
+ * @param dst             Destination calibration file.
+ * @param frames          Maximum number of valid calibration frames.
+ * @param stride          Search every stride-th frame.
+ * @param minDisplacement Minimum mean corner movement in pixels between
+ *                        accepted frames.
+ * @param minSharpness    Skip frames less sharp than this, 0 searches all.
+ */
+void lensCalibrationU(string src, string calibFile, string dst, string frames, string stride = "1", string minDisplacement = "0", string minSharpness = "0")
+{
+    LensCalibration lCalib;
+
+    if (!configureSampling(lCalib, stride, minDisplacement, minSharpness))
+    {
+        return;
+    }
+
+    if (lCalib.fromFile(calibFile) && lCalib.updateFromVideo(src, (size_t) stoi(frames)) && lCalib.store(dst))
+    {
+        cout << "{\"error\":" << lCalib.getReprojectionError() << "}";
+    }
+}
+
 /**
  * Removes lens distortion on an image based on a calibration file.
  * @param src       Source image.
@@ -98,12 +282,9 @@ void lensCalibrationI(string src, string dst, string calibFile)
     if (lCalib.fromFile(calibFile))
     {
         Mat M;
-        if (lCalib.generateMaps())
+        if(lCalib.onImage(src, M))
         {
-            if(lCalib.onImage(src, M))
-            {
-                imwrite(dst, M);
-            }
+            imwrite(dst, M);
         }
     }
 }
@@ -119,11 +300,8 @@ void lensCalibrationP(string x, string y, string calibFile)
     LensCalibration lCalib;
     if (lCalib.fromFile(calibFile))
     {
-        if (lCalib.generateMaps())
-        {
-            Point2f transformed = lCalib.onPoint(Point2f(stof(x), stof(y)));
-            cout << "{\"x\":" << transformed.x << ",\"y\":" << transformed.y << "}";
-        }
+        Point2f transformed = lCalib.onPoint(Point2f(stof(x), stof(y)));
+        cout << "{\"x\":" << transformed.x << ",\"y\":" << transformed.y << "}";
     }
 }
 
@@ -205,6 +383,136 @@ void perspectiveCalibrationP(string x, string y, string calibFile)
     }
 }
 
+/**
+ * Removes lens and perspective distortion on an image in a single pass based
+ * on the calibration files.
+ * @param src        Source image file.
+ * @param dst        Destination image file (with valid extension).
+ * @param lCalibFile Lens calibration file.
+ * @param pCalibFile Perspective calibration file.
+ */
+void rectifyI(string src, string dst, string lCalibFile, string pCalibFile)
+{
+    shared_ptr<LensCalibration> l = make_shared<LensCalibration>(lCalibFile);
+    shared_ptr<PerspectiveCalibration> p = make_shared<PerspectiveCalibration>(pCalibFile);
+    ImageRectifier rectifier(l, p);
+
+    Mat M;
+    if (rectifier.onImage(src, M))
+    {
+        imwrite(dst, M);
+    }
+}
+
+/**
+ * Removes lens and perspective distortion on every image in a directory,
+ * building the maps once and spreading the images across threads.
+ * @param src        Source directory or glob pattern.
+ * @param dst        Destination directory.
+ * @param lCalibFile Lens calibration file, "-" to skip lens correction.
+ * @param pCalibFile Perspective calibration file, "-" or omitted to skip
+ *                   perspective correction.
+ */
+void rectifyD(string src, string dst, string lCalibFile, string pCalibFile = "-")
+{
+    shared_ptr<LensCalibration> l;
+    shared_ptr<PerspectiveCalibration> p;
+
+    if (lCalibFile != "-")
+    {
+        l = make_shared<LensCalibration>(lCalibFile);
+    }
+
+    if (pCalibFile != "-")
+    {
+        p = make_shared<PerspectiveCalibration>(pCalibFile);
+    }
+
+    ImageRectifier rectifier(l, p);
+
+    cout << "{\"images\":" << rectifier.onImages(src, dst) << "}";
+}
+
+/**
+ * Writes a Deep Zoom tile pyramid for each image in a directory, as
+ * <name>.dzi and <name>_files in the output directory.
+ * @param src        Source image, directory or glob pattern.
+ * @param dst        Destination directory.
+ * @param tileSize   Tile size in pixels.
+ * @param overlap    Tile overlap in pixels.
+ * @param lCalibFile Lens calibration file to rectify with, "-" or omitted to
+ *                   skip.
+ */
+void deepZoomD(string src, string dst, string tileSize = "254", string overlap = "1", string lCalibFile = "-")
+{
+    DeepZoom zoom(stoi(tileSize), stoi(overlap));
+
+    if (lCalibFile != "-")
+    {
+        shared_ptr<LensCalibration> l = make_shared<LensCalibration>(lCalibFile);
+
+        if (!l->isCalibrated())
+        {
+            cout << "Calibration file could not be loaded: " << lCalibFile << endl;
+            return;
+        }
+
+        zoom.setRectifier(make_shared<ImageRectifier>(l, nullptr));
+    }
+
+    vector<string> files = ImageFiles::isImage(src) ? vector<string>(1, src) : ImageFiles::list(src);
+    dst = ImageFiles::withSeparator(dst);
+
+    size_t written = 0;
+
+    for (const string& file : files)
+    {
+        if (zoom.setImage(file) && zoom.generate(dst + ImageFiles::stem(file)))
+        {
+            written++;
+        }
+        else
+        {
+            cout << "Image could not be tiled: " << file << endl;
+        }
+    }
+
+    cout << "{\"images\":" << written << "}";
+}
+
+/**
+ * Converts calibration files between formats, typically combining XML/YAML
+ * lens and perspective calibrations into one binary .calib file.
+ * @param dst        Destination calibration file.
+ * @param lCalibFile Lens calibration file, "-" to skip.
+ * @param pCalibFile Perspective calibration file, "-" or omitted to skip.
+ */
+void convertCalibration(string dst, string lCalibFile, string pCalibFile = "-")
+{
+    // Only the binary format holds both calibrations, a markup file would be
+    // overwritten by the second one.
+    bool success = CalibrationFile::isBinary(dst) || lCalibFile == "-" || pCalibFile == "-";
+
+    if (!success)
+    {
+        cout << "Combining calibrations requires a .calib output file." << endl;
+    }
+
+    if (success && lCalibFile != "-")
+    {
+        LensCalibration lCalib;
+        success = lCalib.fromFile(lCalibFile) && lCalib.store(dst);
+    }
+
+    if (success && pCalibFile != "-")
+    {
+        PerspectiveCalibration pCalib;
+        success = pCalib.fromFile(pCalibFile) && pCalib.store(dst);
+    }
+
+    cout << "{\"success\":" << (success ? "true" : "false") << "}";
+}
+
 /**
  * Finds the coordinate of the specified point based on a virtual coordinate
  * system constructed using the calibration files, with the user defined origin
@@ -260,16 +568,621 @@ void imageDistanceD
     cout << "{\"distance\":" << distance << "}";
 }
 
+/**
+ * Escapes a string for use inside a JSON string literal.
+ * @param  value Raw string.
+ * @return       Escaped string, without surrounding quotes.
+ */
+string jsonEscape(const string& value)
+{
+    const char* hex = "0123456789abcdef";
+    ostringstream escaped;
+
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped << '\\' << c;
+        }
+        else if ((unsigned char) c < 0x20)
+        {
+            // Control characters, including newlines that would split the
+            // response line.
+            escaped << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        }
+        else
+        {
+            escaped << c;
+        }
+    }
+
+    return escaped.str();
+}
+
+/**
+ * Parses a single line flat JSON object into a map of raw values. Nested
+ * objects and arrays are not supported as requests only carry strings and
+ * numbers.
+ * @param  line   JSON line.
+ * @param  fields Output map of key to unquoted value.
+ * @return        Boolean indication of success.
+ */
+bool parseRequest(const string& line, map<string, string>& fields)
+{
+    size_t i = 0;
+    size_t n = line.size();
+
+    auto skipSpace = [&]()
+    {
+        while (i < n && isspace((unsigned char) line[i]))
+        {
+            i++;
+        }
+    };
+
+    auto readString = [&](string& out)
+    {
+        if (i >= n || line[i] != '"')
+        {
+            return false;
+        }
+
+        i++;
+        out.clear();
+
+        while (i < n && line[i] != '"')
+        {
+            if (line[i] == '\\' && i + 1 < n)
+            {
+                i++;
+            }
+            out += line[i];
+            i++;
+        }
+
+        if (i >= n)
+        {
+            return false;
+        }
+
+        i++;
+        return true;
+    };
+
+    fields.clear();
+    skipSpace();
+
+    if (i >= n || line[i] != '{')
+    {
+        return false;
+    }
+
+    i++;
+
+    while (true)
+    {
+        string key;
+        string value;
+
+        skipSpace();
+
+        if (i < n && line[i] == '}')
+        {
+            return true;
+        }
+
+        if (!readString(key))
+        {
+            return false;
+        }
+
+        skipSpace();
+
+        if (i >= n || line[i] != ':')
+        {
+            return false;
+        }
+
+        i++;
+        skipSpace();
+
+        if (i < n && line[i] == '"')
+        {
+            if (!readString(value))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            while (i < n && line[i] != ',' && line[i] != '}' && !isspace((unsigned char) line[i]))
+            {
+                value += line[i];
+                i++;
+            }
+        }
+
+        fields[key] = value;
+
+        skipSpace();
+
+        if (i < n && line[i] == ',')
+        {
+            i++;
+        }
+        else if (i < n && line[i] == '}')
+        {
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * Gets the modification time of a file, used to invalidate cached
+ * calibrations when the file is rewritten.
+ * @param  filePath File path.
+ * @return          Modification time, or -1 if the file does not exist.
+ */
+time_t modifiedTime(const string& filePath)
+{
+    struct stat info;
+
+    if (stat(filePath.c_str(), &info) == 0)
+    {
+        return info.st_mtime;
+    }
+
+    return -1;
+}
+
+/**
+ * Calibration objects kept alive by the server, keyed by file path.
+ */
+template <typename T>
+struct CachedCalibration
+{
+    time_t modified;
+    shared_ptr<T> calibration;
+};
+
+/**
+ * Fetches a calibration from the cache, loading it from file on a miss or
+ * when the file has changed since it was loaded.
+ * @param  cache    Calibration cache.
+ * @param  filePath Calibration file.
+ * @return          Loaded calibration or nullptr if it could not be loaded.
+ */
+template <typename T>
+shared_ptr<T> loadCached(map<string, CachedCalibration<T> >& cache, const string& filePath)
+{
+    time_t modified = modifiedTime(filePath);
+    auto it = cache.find(filePath);
+
+    if (it != cache.end() && it->second.modified == modified)
+    {
+        return it->second.calibration;
+    }
+
+    shared_ptr<T> calibration = make_shared<T>();
+
+    if (modified >= 0 && calibration->fromFile(filePath) && calibration->isCalibrated())
+    {
+        cache[filePath] = { modified, calibration };
+        return calibration;
+    }
+
+    cache.erase(filePath);
+    return nullptr;
+}
+
+/**
+ * Runs a persistent server answering newline delimited JSON requests on stdin
+ * with one JSON line on stdout per request. Calibrations are loaded once and
+ * kept in memory keyed by file path, so repeated queries avoid the process
+ * spawn and file parsing costs of the single shot options.
+ *
+ * Requests (an optional "id" is echoed back):
+ * {"type":"point","x":0,"y":0,"originX":0,"originY":0,"lens":"","perspective":""}
+ * {"type":"distance","startX":0,"startY":0,"endX":0,"endY":0,"lens":"","perspective":""}
+ * {"type":"lensPoint","x":0,"y":0,"lens":""}
+ * {"type":"perspectivePoint","x":0,"y":0,"perspective":""}
+ * {"type":"videoInfo","video":""}
+ * {"type":"frame","video":"","index":0}
+ * {"type":"frameStats","video":""}
+ * {"type":"dzi","video":"","index":0,"tileSize":254,"overlap":1,"lens":""}
+ * {"type":"tile","video":"","index":0,"level":0,"col":0,"row":0,"tileSize":254,"overlap":1,"lens":""}
+ *
+ * Frame and tile responses give the JPEG size in bytes, and the encoded image
+ * follows immediately after the response line. Deep Zoom requests take an
+ * "image" path instead of "video" and "index" to tile an image file, and
+ * "tileSize", "overlap" and "lens" are optional.
+ */
+void serve()
+{
+    map<string, CachedCalibration<LensCalibration> > lensCache;
+    map<string, CachedCalibration<PerspectiveCalibration> > perspectiveCache;
+    // Only the last video is kept open, as each server holds its own frame
+    // cache and read-ahead thread and the app views one video at a time.
+    shared_ptr<FrameServer> currentVideo;
+    string currentVideoPath;
+
+#ifdef _WIN32
+    // Frames are written as raw bytes.
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    auto openVideo = [&](const string& filePath)
+    {
+        if (!currentVideo || filePath != currentVideoPath || !currentVideo->isOpened())
+        {
+            // Released first so two caches are never held at once.
+            currentVideo.reset();
+            currentVideoPath.clear();
+
+            currentVideo = make_shared<FrameServer>(filePath);
+
+            if (!currentVideo->isOpened())
+            {
+                currentVideo.reset();
+                throw runtime_error("Video file could not be opened.");
+            }
+
+            currentVideoPath = filePath;
+        }
+
+        return currentVideo;
+    };
+
+    string line;
+    map<string, string> fields;
+
+    auto number = [&](const string& key)
+    {
+        return stof(fields.at(key));
+    };
+
+    // The pyramid of the last tiled image is kept, as a viewer requests many
+    // tiles of the same image in a row.
+    shared_ptr<DeepZoom> zoom;
+    string zoomKey;
+
+    // Rectifiers are kept per lens file so stepping through frames reuses the
+    // maps, along with the calibration they were built for.
+    map<string, pair<shared_ptr<LensCalibration>, shared_ptr<ImageRectifier> > > rectifiers;
+
+    auto openZoom = [&]()
+    {
+        string lens = fields.count("lens") ? fields["lens"] : "";
+        int tileSize = fields.count("tileSize") ? stoi(fields["tileSize"]) : 254;
+        int overlap = fields.count("overlap") ? stoi(fields["overlap"]) : 1;
+        string source = fields.count("image") ? fields["image"] : fields.at("video") + "#" + fields.at("index");
+        string key = source + "|" + lens + "|" + to_string(tileSize) + "|" + to_string(overlap);
+
+        shared_ptr<ImageRectifier> rectifier;
+
+        if (!lens.empty())
+        {
+            shared_ptr<LensCalibration> l = loadCached(lensCache, lens);
+
+            if (!l)
+            {
+                throw runtime_error("Calibration file could not be loaded.");
+            }
+
+            pair<shared_ptr<LensCalibration>, shared_ptr<ImageRectifier> >& cached = rectifiers[lens];
+
+            // A changed calibration file is reloaded as a new object, and the
+            // pyramid rectified with the old one can no longer be reused.
+            if (cached.first != l)
+            {
+                cached = make_pair(l, make_shared<ImageRectifier>(l, nullptr));
+                zoomKey.clear();
+            }
+
+            rectifier = cached.second;
+        }
+
+        if (key == zoomKey)
+        {
+            return;
+        }
+
+        zoomKey.clear();
+        zoom = make_shared<DeepZoom>(tileSize, overlap);
+
+        if (rectifier)
+        {
+            zoom->setRectifier(rectifier);
+        }
+
+        Mat image;
+
+        if (fields.count("image"))
+        {
+            image = imread(fields["image"]);
+        }
+        else if (!openVideo(fields.at("video"))->getFrame((size_t) stoul(fields.at("index")), image))
+        {
+            throw runtime_error("Frame could not be decoded.");
+        }
+
+        if (!zoom->setImage(image))
+        {
+            throw runtime_error("Image could not be tiled.");
+        }
+
+        zoomKey = key;
+    };
+
+    while (getline(cin, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+
+        if (line.empty())
+        {
+            continue;
+        }
+
+        ostringstream response;
+        vector<uchar> payload;
+
+        if (!parseRequest(line, fields))
+        {
+            cout << "{\"error\":\"Request is not a valid JSON object.\"}" << endl;
+            continue;
+        }
+
+        string id;
+
+        if (fields.count("id"))
+        {
+            id = "\"id\":\"" + jsonEscape(fields["id"]) + "\",";
+        }
+
+        try
+        {
+            const string& type = fields.at("type");
+
+            if (type == "point" || type == "distance")
+            {
+                shared_ptr<LensCalibration> l = loadCached(lensCache, fields.at("lens"));
+                shared_ptr<PerspectiveCalibration> p = loadCached(perspectiveCache, fields.at("perspective"));
+
+                if (!l || !p)
+                {
+                    throw runtime_error("Calibration file could not be loaded.");
+                }
+
+                if (type == "point")
+                {
+                    ImageDistance imgDst(l, p, Point2f(number("originX"), number("originY")));
+                    Point2f transformed = imgDst.getRealCoordinate(Point2f(number("x"), number("y")));
+
+                    response << "{" << id << "\"x\":" << transformed.x << ",\"y\":" << transformed.y << "}";
+                }
+                else
+                {
+                    ImageDistance imgDst(l, p);
+                    double distance = imgDst.getRealDistance(Point2f(number("startX"), number("startY")), Point2f(number("endX"), number("endY")));
+
+                    response << "{" << id << "\"distance\":" << distance << "}";
+                }
+            }
+            else if (type == "lensPoint")
+            {
+                shared_ptr<LensCalibration> l = loadCached(lensCache, fields.at("lens"));
+
+                if (!l)
+                {
+                    throw runtime_error("Calibration file could not be loaded.");
+                }
+
+                // Interactive queries repeat on the same calibration, so
+                // answer them from the interpolated grid.
+                if (!l->hasLookup())
+                {
+                    l->generateLookup();
+                }
+
+                Point2f transformed = l->onPoint(Point2f(number("x"), number("y")));
+
+                response << "{" << id << "\"x\":" << transformed.x << ",\"y\":" << transformed.y << "}";
+            }
+            else if (type == "perspectivePoint")
+            {
+                shared_ptr<PerspectiveCalibration> p = loadCached(perspectiveCache, fields.at("perspective"));
+
+                if (!p)
+                {
+                    throw runtime_error("Calibration file could not be loaded.");
+                }
+
+                Point2f transformed = p->onPoint(Point2f(number("x"), number("y")));
+
+                response << "{" << id << "\"x\":" << transformed.x << ",\"y\":" << transformed.y << "}";
+            }
+            else if (type == "videoInfo")
+            {
+                shared_ptr<FrameServer> video = openVideo(fields.at("video"));
+
+                response << "{" << id << "\"frames\":" << video->getFrameCount() << ",\"fps\":" << video->getFps() << "}";
+            }
+            else if (type == "frame")
+            {
+                shared_ptr<FrameServer> video = openVideo(fields.at("video"));
+                size_t index = (size_t) stoul(fields.at("index"));
+
+                if (!video->getEncoded(index, payload))
+                {
+                    throw runtime_error("Frame could not be decoded.");
+                }
+
+                response << "{" << id << "\"index\":" << index << ",\"size\":" << payload.size() << "}";
+            }
+            else if (type == "dzi")
+            {
+                openZoom();
+
+                Size size = zoom->getLevelSize(zoom->getMaxLevel());
+
+                response << "{" << id << "\"width\":" << size.width << ",\"height\":" << size.height
+                    << ",\"tileSize\":" << zoom->getTileSize() << ",\"overlap\":" << zoom->getOverlap()
+                    << ",\"maxLevel\":" << zoom->getMaxLevel() << "}";
+            }
+            else if (type == "tile")
+            {
+                openZoom();
+
+                int level = stoi(fields.at("level"));
+
+                if (!zoom->getEncodedTile(level, stoi(fields.at("col")), stoi(fields.at("row")), payload))
+                {
+                    throw runtime_error("Tile is out of range.");
+                }
+
+                response << "{" << id << "\"level\":" << level << ",\"size\":" << payload.size() << "}";
+            }
+            else if (type == "frameStats")
+            {
+                shared_ptr<FrameServer> video = openVideo(fields.at("video"));
+
+                response << "{" << id << "\"hits\":" << video->getHits() << ",\"misses\":" << video->getMisses()
+                    << ",\"bytes\":" << video->getCacheBytes() << "}";
+            }
+            else
+            {
+                throw runtime_error("Unknown request type.");
+            }
+        }
+        catch (const out_of_range&)
+        {
+            payload.clear();
+            response.str("");
+            response << "{" << id << "\"error\":\"Request is missing a field.\"}";
+        }
+        catch (const invalid_argument&)
+        {
+            payload.clear();
+            response.str("");
+            response << "{" << id << "\"error\":\"Request contains an invalid number.\"}";
+        }
+        catch (const cv::Exception&)
+        {
+            payload.clear();
+            response.str("");
+            response << "{" << id << "\"error\":\"OpenCV could not process the request.\"}";
+        }
+        catch (const exception& e)
+        {
+            payload.clear();
+            response.str("");
+            response << "{" << id << "\"error\":\"" << jsonEscape(e.what()) << "\"}";
+        }
+
+        cout << response.str() << "\n";
+
+        if (!payload.empty())
+        {
+            cout.write((const char*) payload.data(), (streamsize) payload.size());
+        }
+
+        cout << flush;
+    }
+}
+
 int main(int argc, char** argv)
 {
     string option = argv[1];
-    if (option == "-E")
+    if (option == "--serve")
+    {
+        serve();
+    }
+    else if (option == "-E")
     {
         extractImages(argv[2], argv[3]);
     }
     else if (option == "-Lf")
     {
-        lensCalibrationF(argv[2], argv[3], argv[4]);
+        if (argc > 7)
+        {
+            lensCalibrationF(argv[2], argv[3], argv[4], argv[5], argv[6], argv[7]);
+        }
+        else if (argc > 6)
+        {
+            lensCalibrationF(argv[2], argv[3], argv[4], argv[5], argv[6]);
+        }
+        else if (argc > 5)
+        {
+            lensCalibrationF(argv[2], argv[3], argv[4], argv[5]);
+        }
+        else
+        {
+            lensCalibrationF(argv[2], argv[3], argv[4]);
+        }
+    }
+    else if (option == "-Ld")
+    {
+        if (argc > 6)
+        {
+            lensCalibrationD(argv[2], argv[3], argv[4], argv[5], argv[6]);
+        }
+        else if (argc > 5)
+        {
+            lensCalibrationD(argv[2], argv[3], argv[4], argv[5]);
+        }
+        else if (argc > 4)
+        {
+            lensCalibrationD(argv[2], argv[3], argv[4]);
+        }
+        else
+        {
+            lensCalibrationD(argv[2], argv[3]);
+        }
+    }
+    else if (option == "-Lt")
+    {
+        if (argc > 8)
+        {
+            lensCalibrationT(argv[2], argv[3], argv[4], argv[5], argv[6], argv[7], argv[8]);
+        }
+        else if (argc > 7)
+        {
+            lensCalibrationT(argv[2], argv[3], argv[4], argv[5], argv[6], argv[7]);
+        }
+        else if (argc > 6)
+        {
+            lensCalibrationT(argv[2], argv[3], argv[4], argv[5], argv[6]);
+        }
+        else
+        {
+            lensCalibrationT(argv[2], argv[3], argv[4], argv[5]);
+        }
+    }
+    else if (option == "-Lu")
+    {
+        if (argc > 8)
+        {
+            lensCalibrationU(argv[2], argv[3], argv[4], argv[5], argv[6], argv[7], argv[8]);
+        }
+        else if (argc > 7)
+        {
+            lensCalibrationU(argv[2], argv[3], argv[4], argv[5], argv[6], argv[7]);
+        }
+        else if (argc > 6)
+        {
+            lensCalibrationU(argv[2], argv[3], argv[4], argv[5], argv[6]);
+        }
+        else
+        {
+            lensCalibrationU(argv[2], argv[3], argv[4], argv[5]);
+        }
     }
     else if (option == "-Li")
     {
@@ -299,6 +1212,51 @@ int main(int argc, char** argv)
     {
         perspectiveCalibrationP(argv[2], argv[3], argv[4]);
     }
+    else if (option == "-Ri")
+    {
+        rectifyI(argv[2], argv[3], argv[4], argv[5]);
+    }
+    else if (option == "-Rd")
+    {
+        if (argc > 5)
+        {
+            rectifyD(argv[2], argv[3], argv[4], argv[5]);
+        }
+        else
+        {
+            rectifyD(argv[2], argv[3], argv[4]);
+        }
+    }
+    else if (option == "-Z")
+    {
+        if (argc > 6)
+        {
+            deepZoomD(argv[2], argv[3], argv[4], argv[5], argv[6]);
+        }
+        else if (argc > 5)
+        {
+            deepZoomD(argv[2], argv[3], argv[4], argv[5]);
+        }
+        else if (argc > 4)
+        {
+            deepZoomD(argv[2], argv[3], argv[4]);
+        }
+        else
+        {
+            deepZoomD(argv[2], argv[3]);
+        }
+    }
+    else if (option == "-C")
+    {
+        if (argc > 4)
+        {
+            convertCalibration(argv[2], argv[3], argv[4]);
+        }
+        else
+        {
+            convertCalibration(argv[2], argv[3]);
+        }
+    }
     else if (option == "-Ip")
     {
         imageDistanceP
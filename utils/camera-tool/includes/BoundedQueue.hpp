@@ -0,0 +1,93 @@
+/**
+ * BoundedQueue.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module provides a blocking fixed capacity queue used to hand work
+ * between the decoding and processing threads of a pipeline, so a fast
+ * producer cannot buffer an entire video in memory.
+ */
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+
+template <typename T>
+class BoundedQueue
+{
+private:
+    std::queue<T> items;
+    size_t capacity;
+    bool closed;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    explicit BoundedQueue(size_t capacity)
+    :capacity(capacity > 0 ? capacity : 1),
+    closed(false)
+    {
+
+    }
+
+    /**
+     * Add an item, waiting while the queue is full.
+     * @param  item Item to add.
+     * @return      False if the queue was closed and the item was dropped.
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->notFull.wait(lock, [this]() { return this->closed || this->items.size() < this->capacity; });
+
+        if (this->closed)
+        {
+            return false;
+        }
+
+        this->items.push(std::move(item));
+        this->notEmpty.notify_one();
+
+        return true;
+    }
+
+    /**
+     * Take the oldest item, waiting while the queue is empty.
+     * @param  item Output item.
+     * @return      False once the queue is closed and has been drained.
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->notEmpty.wait(lock, [this]() { return this->closed || !this->items.empty(); });
+
+        if (this->items.empty())
+        {
+            return false;
+        }
+
+        item = std::move(this->items.front());
+        this->items.pop();
+        this->notFull.notify_one();
+
+        return true;
+    }
+
+    /**
+     * Stop accepting items and wake all waiting threads. Items already in the
+     * queue can still be popped.
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closed = true;
+        this->notFull.notify_all();
+        this->notEmpty.notify_all();
+    }
+};
+
+#endif /* BOUNDEDQUEUE_H */
@@ -0,0 +1,231 @@
+/**
+ * CalibrationFile.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "CalibrationFile.hpp"
+#include "Checksum.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    const char magic[8] = { 'C', 'T', 'C', 'A', 'L', 'I', 'B', 0 };
+    const uint32_t version = 1;
+}
+
+bool CalibrationFile::isBinary(const string& filePath)
+{
+    const string extension = ".calib";
+
+    return filePath.length() >= extension.length()
+        && filePath.compare(filePath.length() - extension.length(), extension.length(), extension) == 0;
+}
+
+bool CalibrationFile::read(string filePath)
+{
+    ifstream in(filePath, ios::binary);
+
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    vector<char> contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    size_t headerSize = sizeof(magic) + 2 * sizeof(uint32_t);
+
+    if (contents.size() < headerSize + sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    size_t bodySize = contents.size() - sizeof(uint32_t);
+    uint32_t crc = 0;
+    memcpy(&crc, contents.data() + bodySize, sizeof(uint32_t));
+
+    if (memcmp(contents.data(), magic, sizeof(magic)) != 0 || crc != Checksum::crc32(contents.data(), bodySize))
+    {
+        return false;
+    }
+
+    contents.resize(bodySize);
+
+    size_t offset = sizeof(magic);
+    uint32_t fileVersion = 0;
+    uint32_t count = 0;
+
+    take(contents, offset, fileVersion);
+    take(contents, offset, count);
+
+    // Newer versions may change section layouts this build does not know.
+    if (fileVersion > version)
+    {
+        return false;
+    }
+
+    map<uint32_t, vector<char> > loaded;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t tag = 0;
+        uint32_t length = 0;
+
+        if (!take(contents, offset, tag) || !take(contents, offset, length) || offset + length > contents.size())
+        {
+            return false;
+        }
+
+        loaded[tag].assign(contents.begin() + offset, contents.begin() + offset + length);
+        offset += length;
+    }
+
+    this->sections.swap(loaded);
+
+    return true;
+}
+
+bool CalibrationFile::write(string filePath)
+{
+    vector<char> contents(magic, magic + sizeof(magic));
+
+    put(contents, version);
+    put(contents, (uint32_t) this->sections.size());
+
+    for (const auto& section : this->sections)
+    {
+        put(contents, section.first);
+        put(contents, (uint32_t) section.second.size());
+        contents.insert(contents.end(), section.second.begin(), section.second.end());
+    }
+
+    put(contents, Checksum::crc32(contents.data(), contents.size()));
+
+    // Written beside the destination and renamed over it, so a crash never
+    // leaves a truncated calibration behind.
+    string tempPath = filePath + ".tmp";
+
+    {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        out.write(contents.data(), contents.size());
+
+        if (!out)
+        {
+            out.close();
+            remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // Windows will not rename over an existing file.
+    remove(filePath.c_str());
+#endif
+
+    if (rename(tempPath.c_str(), filePath.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool CalibrationFile::hasSection(uint32_t tag)
+{
+    return this->sections.count(tag) > 0;
+}
+
+vector<char> CalibrationFile::getSection(uint32_t tag)
+{
+    auto it = this->sections.find(tag);
+
+    return it != this->sections.end() ? it->second : vector<char>();
+}
+
+void CalibrationFile::setSection(uint32_t tag, const vector<char>& payload)
+{
+    this->sections[tag] = payload;
+}
+
+void CalibrationFile::putMatrix(vector<char>& payload, const Mat& matrix)
+{
+    Mat values;
+
+    if (!matrix.empty())
+    {
+        matrix.convertTo(values, CV_64F);
+    }
+
+    put(payload, (int32_t) values.rows);
+    put(payload, (int32_t) values.cols);
+
+    const char* bytes = reinterpret_cast<const char*>(values.data);
+    payload.insert(payload.end(), bytes, bytes + values.total() * sizeof(double));
+}
+
+bool CalibrationFile::takeMatrix(const vector<char>& payload, size_t& offset, Mat& matrix)
+{
+    int32_t rows = 0;
+    int32_t cols = 0;
+
+    if (!take(payload, offset, rows) || !take(payload, offset, cols) || rows < 0 || cols < 0)
+    {
+        return false;
+    }
+
+    size_t bytes = (size_t) rows * (size_t) cols * sizeof(double);
+
+    if (offset + bytes > payload.size())
+    {
+        return false;
+    }
+
+    if (bytes == 0)
+    {
+        matrix = Mat();
+        return true;
+    }
+
+    matrix.create(rows, cols, CV_64F);
+    memcpy(matrix.data, payload.data() + offset, bytes);
+    offset += bytes;
+
+    return true;
+}
+
+void CalibrationFile::putPoints(vector<char>& payload, const vector<Point2f>& points)
+{
+    put(payload, (uint32_t) points.size());
+
+    for (const Point2f& point : points)
+    {
+        put(payload, point.x);
+        put(payload, point.y);
+    }
+}
+
+bool CalibrationFile::takePoints(const vector<char>& payload, size_t& offset, vector<Point2f>& points)
+{
+    uint32_t count = 0;
+
+    if (!take(payload, offset, count) || offset + (size_t) count * 2 * sizeof(float) > payload.size())
+    {
+        return false;
+    }
+
+    points.resize(count);
+
+    for (Point2f& point : points)
+    {
+        take(payload, offset, point.x);
+        take(payload, offset, point.y);
+    }
+
+    return true;
+}
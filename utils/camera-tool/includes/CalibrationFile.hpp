@@ -0,0 +1,149 @@
+/**
+ * CalibrationFile.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module reads and writes the binary .calib calibration format, a
+ * compact alternative to the XML/YAML files that loads without any text
+ * parsing. A file holds tagged sections, so one file can carry both the lens
+ * and perspective calibrations, and ends in a CRC-32 of its contents. Values
+ * are stored in host byte order, which is little endian on every supported
+ * target.
+ *
+ * Layout: "CTCALIB" magic, version, section count, then per section a tag,
+ * byte length and payload, then the CRC.
+ */
+
+#ifndef CALIBRATIONFILE_H
+#define CALIBRATIONFILE_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+class CalibrationFile
+{
+public:
+    enum SectionTag : uint32_t
+    {
+        lensSection = 1,
+        perspectiveSection = 2,
+        detectionSection = 3
+    };
+
+    /**
+     * Check if a file name uses the binary calibration extension.
+     * @param  filePath File name.
+     * @return          If the extension is .calib.
+     */
+    static bool isBinary(const std::string& filePath);
+
+    /**
+     * Read and verify a calibration file, replacing any loaded sections.
+     * @param  filePath Calibration file.
+     * @return          Boolean indication of success.
+     */
+    bool read(std::string filePath);
+
+    /**
+     * Write the loaded sections to a calibration file.
+     * @param  filePath Calibration file.
+     * @return          Boolean indication of success.
+     */
+    bool write(std::string filePath);
+
+    /**
+     * Check if a section is loaded.
+     * @param  tag Section tag.
+     * @return     Boolean.
+     */
+    bool hasSection(uint32_t tag);
+
+    /**
+     * Get the payload of a section.
+     * @param  tag Section tag.
+     * @return     Payload bytes, empty if the section is missing.
+     */
+    std::vector<char> getSection(uint32_t tag);
+
+    /**
+     * Add or replace a section.
+     * @param tag     Section tag.
+     * @param payload Payload bytes.
+     */
+    void setSection(uint32_t tag, const std::vector<char>& payload);
+
+    /**
+     * Append a trivially copyable value to a payload.
+     * @param payload Payload bytes.
+     * @param value   Value to append.
+     */
+    template<class T>
+    static void put(std::vector<char>& payload, const T& value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        payload.insert(payload.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * Read a trivially copyable value from a payload.
+     * @param  payload Payload bytes.
+     * @param  offset  Read position, advanced past the value.
+     * @param  value   Output value.
+     * @return         False if the payload is too short.
+     */
+    template<class T>
+    static bool take(const std::vector<char>& payload, size_t& offset, T& value)
+    {
+        if (offset + sizeof(T) > payload.size())
+        {
+            return false;
+        }
+
+        std::memcpy(&value, payload.data() + offset, sizeof(T));
+        offset += sizeof(T);
+
+        return true;
+    }
+
+    /**
+     * Append a matrix to a payload as its shape followed by double values.
+     * @param payload Payload bytes.
+     * @param matrix  Single channel matrix.
+     */
+    static void putMatrix(std::vector<char>& payload, const cv::Mat& matrix);
+
+    /**
+     * Read a matrix written by putMatrix.
+     * @param  payload Payload bytes.
+     * @param  offset  Read position, advanced past the matrix.
+     * @param  matrix  Output CV_64F matrix.
+     * @return         False if the payload is too short.
+     */
+    static bool takeMatrix(const std::vector<char>& payload, size_t& offset, cv::Mat& matrix);
+
+    /**
+     * Append a list of points to a payload.
+     * @param payload Payload bytes.
+     * @param points  Points.
+     */
+    static void putPoints(std::vector<char>& payload, const std::vector<cv::Point2f>& points);
+
+    /**
+     * Read a list of points written by putPoints.
+     * @param  payload Payload bytes.
+     * @param  offset  Read position, advanced past the points.
+     * @param  points  Output points.
+     * @return         False if the payload is too short.
+     */
+    static bool takePoints(const std::vector<char>& payload, size_t& offset, std::vector<cv::Point2f>& points);
+
+private:
+    std::map<uint32_t, std::vector<char> > sections;
+};
+
+#endif /* CALIBRATIONFILE_H */
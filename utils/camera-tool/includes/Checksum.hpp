@@ -0,0 +1,109 @@
+/**
+ * Checksum.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * Hashing helpers used to key and validate the binary calibration and cache
+ * files.
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Checksum
+{
+    const uint64_t fnvOffset = 14695981039346656037ULL;
+    const uint64_t fnvPrime = 1099511628211ULL;
+
+    /**
+     * Continue a 64 bit FNV-1a hash over a block of bytes.
+     * @param  data  Bytes to hash.
+     * @param  size  Number of bytes.
+     * @param  hash  Hash so far, fnvOffset to start.
+     * @return       Updated hash.
+     */
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = fnvOffset)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= fnvPrime;
+        }
+
+        return hash;
+    }
+
+    /**
+     * Continue a hash over the values of a matrix, converted to doubles so the
+     * same values hash the same regardless of how they were loaded. The shape
+     * is included so an empty matrix differs from a zero one.
+     * @param  matrix Matrix to hash.
+     * @param  hash   Hash so far.
+     * @return        Updated hash.
+     */
+    inline uint64_t fnv1a(const cv::Mat& matrix, uint64_t hash = fnvOffset)
+    {
+        int shape[2] = { matrix.rows, matrix.cols * matrix.channels() };
+        hash = fnv1a(shape, sizeof(shape), hash);
+
+        if (!matrix.empty())
+        {
+            cv::Mat values;
+            matrix.convertTo(values, CV_64F);
+
+            hash = fnv1a(values.data, values.total() * values.elemSize(), hash);
+        }
+
+        return hash;
+    }
+
+    /**
+     * Compute the CRC-32 (IEEE 802.3) of a block of bytes.
+     * @param  data Bytes to check.
+     * @param  size Number of bytes.
+     * @return      CRC.
+     */
+    inline uint32_t crc32(const void* data, size_t size)
+    {
+        struct Table
+        {
+            uint32_t entries[256];
+
+            Table()
+            {
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t c = i;
+
+                    for (int k = 0; k < 8; k++)
+                    {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+
+                    this->entries[i] = c;
+                }
+            }
+        };
+
+        static const Table table;
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint32_t crc = 0xFFFFFFFFu;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        }
+
+        return crc ^ 0xFFFFFFFFu;
+    }
+}
+
+#endif /* CHECKSUM_H */
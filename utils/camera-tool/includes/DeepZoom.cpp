@@ -0,0 +1,269 @@
+/**
+ * DeepZoom.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "DeepZoom.hpp"
+#include "ImageFiles.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    struct TileTask
+    {
+        int level;
+        int col;
+        int row;
+    };
+
+    int tileCount(int length, int tileSize)
+    {
+        return (length + tileSize - 1) / tileSize;
+    }
+}
+
+DeepZoom::DeepZoom(int tileSize, int overlap, string format)
+:tileSize(max(tileSize, 1)),
+overlap(max(overlap, 0)),
+format(format),
+threads(0)
+{
+
+}
+
+void DeepZoom::setThreads(unsigned int count)
+{
+    this->threads = count;
+}
+
+void DeepZoom::setRectifier(shared_ptr<ImageRectifier> r)
+{
+    this->rectifier = r;
+}
+
+bool DeepZoom::setImage(const Mat& image)
+{
+    lock_guard<mutex> lock(this->levelMutex);
+
+    this->levels.clear();
+
+    if (image.empty())
+    {
+        return false;
+    }
+
+    // The rectified image gets its own buffer, as the caller's may be shared,
+    // such as a frame held in a FrameServer cache.
+    Mat source;
+
+    if (this->rectifier)
+    {
+        if (!this->rectifier->generateMaps(image.size()) || !this->rectifier->onImage(image, source))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        source = image;
+    }
+
+    // Level n halves level n + 1 (rounding up) until a single pixel remains.
+    int maxLevel = (int) ceil(log2((double) max(source.cols, source.rows)));
+    this->levels.resize(maxLevel + 1);
+    this->levels[maxLevel] = source;
+
+    return true;
+}
+
+bool DeepZoom::setImage(string imagePath)
+{
+    return this->setImage(imread(imagePath));
+}
+
+int DeepZoom::getTileSize()
+{
+    return this->tileSize;
+}
+
+int DeepZoom::getOverlap()
+{
+    return this->overlap;
+}
+
+int DeepZoom::getMaxLevel()
+{
+    lock_guard<mutex> lock(this->levelMutex);
+
+    return (int) this->levels.size() - 1;
+}
+
+Size DeepZoom::getLevelSize(int level)
+{
+    lock_guard<mutex> lock(this->levelMutex);
+
+    int maxLevel = (int) this->levels.size() - 1;
+
+    if (level < 0 || level > maxLevel)
+    {
+        return Size();
+    }
+
+    Size full = this->levels[maxLevel].size();
+    double scale = pow(2.0, maxLevel - level);
+
+    return Size((int) ceil(full.width / scale), (int) ceil(full.height / scale));
+}
+
+const Mat& DeepZoom::getLevel(int level)
+{
+    lock_guard<mutex> lock(this->levelMutex);
+
+    // Downscale step by step from the nearest level already built, which is
+    // much cheaper than resizing the full image for every level.
+    int built = level;
+
+    while (this->levels[built].empty())
+    {
+        built++;
+    }
+
+    for (; built > level; built--)
+    {
+        const Mat& above = this->levels[built];
+        resize(above, this->levels[built - 1], Size((above.cols + 1) / 2, (above.rows + 1) / 2), 0, 0, INTER_AREA);
+    }
+
+    return this->levels[level];
+}
+
+string DeepZoom::getDescriptor()
+{
+    Size size = this->getLevelSize(this->getMaxLevel());
+    stringstream descriptor;
+
+    descriptor << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"" << this->format
+        << "\" Overlap=\"" << this->overlap << "\" TileSize=\"" << this->tileSize << "\">\n"
+        << "  <Size Width=\"" << size.width << "\" Height=\"" << size.height << "\"/>\n"
+        << "</Image>\n";
+
+    return descriptor.str();
+}
+
+bool DeepZoom::getTile(int level, int col, int row, Mat& tile)
+{
+    Size size = this->getLevelSize(level);
+
+    if (size.area() <= 0 || col < 0 || row < 0
+        || col >= tileCount(size.width, this->tileSize) || row >= tileCount(size.height, this->tileSize))
+    {
+        return false;
+    }
+
+    // Tiles extend by the overlap into each neighbour that exists.
+    int x = col * this->tileSize - (col > 0 ? this->overlap : 0);
+    int y = row * this->tileSize - (row > 0 ? this->overlap : 0);
+    int right = min((col + 1) * this->tileSize + this->overlap, size.width);
+    int bottom = min((row + 1) * this->tileSize + this->overlap, size.height);
+
+    tile = this->getLevel(level)(Rect(x, y, right - x, bottom - y));
+
+    return true;
+}
+
+bool DeepZoom::getEncodedTile(int level, int col, int row, vector<uchar>& buffer)
+{
+    Mat tile;
+
+    return this->getTile(level, col, row, tile) && imencode("." + this->format, tile, buffer);
+}
+
+bool DeepZoom::generate(string dst)
+{
+    int maxLevel = this->getMaxLevel();
+
+    if (maxLevel < 0)
+    {
+        return false;
+    }
+
+    string tileDir = dst + "_files";
+
+    if (!ImageFiles::makeDirectory(tileDir))
+    {
+        return false;
+    }
+
+    // Levels are built up front so the workers only crop and encode.
+    vector<TileTask> tasks;
+
+    for (int level = maxLevel; level >= 0; level--)
+    {
+        Size size = this->getLevelSize(level);
+        this->getLevel(level);
+
+        if (!ImageFiles::makeDirectory(tileDir + "/" + to_string(level)))
+        {
+            return false;
+        }
+
+        for (int row = 0; row < tileCount(size.height, this->tileSize); row++)
+        {
+            for (int col = 0; col < tileCount(size.width, this->tileSize); col++)
+            {
+                tasks.push_back({ level, col, row });
+            }
+        }
+    }
+
+    unsigned int workerCount = this->threads > 0 ? this->threads : max(thread::hardware_concurrency(), 1u);
+    workerCount = (unsigned int) min((size_t) workerCount, tasks.size());
+
+    atomic<size_t> next(0);
+    atomic<bool> failed(false);
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            Mat tile;
+
+            for (size_t index = next++; index < tasks.size(); index = next++)
+            {
+                const TileTask& task = tasks[index];
+                string tilePath = tileDir + "/" + to_string(task.level) + "/"
+                    + to_string(task.col) + "_" + to_string(task.row) + "." + this->format;
+
+                if (!this->getTile(task.level, task.col, task.row, tile) || !imwrite(tilePath, tile))
+                {
+                    failed = true;
+                }
+            }
+        });
+    }
+
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    ofstream descriptor(dst + ".dzi");
+    descriptor << this->getDescriptor();
+
+    return !failed && descriptor.good();
+}
@@ -0,0 +1,129 @@
+/**
+ * DeepZoom.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module cuts an image into a Deep Zoom (DZI) tile pyramid as read by
+ * OpenSeadragon, so a viewer only decodes the tiles covering the visible
+ * region at the current zoom instead of the full frame. A whole pyramid can
+ * be written to disk with tiles encoded across a pool of threads, or single
+ * tiles produced on demand. Images may be rectified before tiling.
+ */
+
+#ifndef DEEPZOOM_H
+#define DEEPZOOM_H
+
+#include "ImageRectifier.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class DeepZoom
+{
+private:
+    int tileSize;
+    int overlap;
+    std::string format;
+    unsigned int threads;
+    std::shared_ptr<ImageRectifier> rectifier;
+
+    std::vector<cv::Mat> levels;    // Index is the DZI level, built lazily from the top
+    std::mutex levelMutex;
+
+    const cv::Mat& getLevel(int level);
+
+public:
+    DeepZoom(int tileSize = 254, int overlap = 1, std::string format = "jpg");
+
+    /**
+     * Set the number of threads used to encode tiles in generate.
+     * @param count Thread count, 0 uses the hardware concurrency.
+     */
+    void setThreads(unsigned int count);
+
+    /**
+     * Set a rectifier applied to images before they are tiled.
+     * @param r Rectifier, null to tile images as they are.
+     */
+    void setRectifier(std::shared_ptr<ImageRectifier> r);
+
+    /**
+     * Set the image to tile, rectifying it first if a rectifier is set.
+     * @param  image BGR image.
+     * @return       Boolean indication of success.
+     */
+    bool setImage(const cv::Mat& image);
+
+    /**
+     * Set the image to tile from a file.
+     * @param  imagePath Image file.
+     * @return           Boolean indication of success.
+     */
+    bool setImage(std::string imagePath);
+
+    /**
+     * Get the tile size, excluding overlap.
+     * @return Tile size in pixels.
+     */
+    int getTileSize();
+
+    /**
+     * Get the overlap between neighbouring tiles.
+     * @return Overlap in pixels.
+     */
+    int getOverlap();
+
+    /**
+     * Get the highest level, which holds the image at full resolution.
+     * Level 0 is a single pixel.
+     * @return Level number, -1 if no image is set.
+     */
+    int getMaxLevel();
+
+    /**
+     * Get the image size at a level.
+     * @param  level Level number.
+     * @return       Size.
+     */
+    cv::Size getLevelSize(int level);
+
+    /**
+     * Get the DZI descriptor XML of the current image.
+     * @return Descriptor.
+     */
+    std::string getDescriptor();
+
+    /**
+     * Cut a single tile, including its overlap with neighbouring tiles.
+     * Levels are downscaled once and kept, so later tiles are only crops.
+     * @param  level Level number.
+     * @param  col   Tile column.
+     * @param  row   Tile row.
+     * @param  tile  Output tile, a view into the level image.
+     * @return       False if the tile is out of range.
+     */
+    bool getTile(int level, int col, int row, cv::Mat& tile);
+
+    /**
+     * Cut a single tile encoded in the tile format.
+     * @param  level  Level number.
+     * @param  col    Tile column.
+     * @param  row    Tile row.
+     * @param  buffer Output encoded bytes.
+     * @return        False if the tile is out of range.
+     */
+    bool getEncodedTile(int level, int col, int row, std::vector<uchar>& buffer);
+
+    /**
+     * Write the whole pyramid as dst.dzi and the dst_files tile directory.
+     * @param  dst Output path without extension.
+     * @return     Boolean indication of success.
+     */
+    bool generate(std::string dst);
+};
+
+#endif /* DEEPZOOM_H */
@@ -0,0 +1,120 @@
+/**
+ * DetectionCache.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "DetectionCache.hpp"
+#include "CalibrationFile.hpp"
+#include "Checksum.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    // Bytes hashed from each end of the video, enough to cover the container
+    // header and index.
+    const size_t sampleBytes = 1 << 16;
+}
+
+uint64_t DetectionCache::videoKey(string filePath, uint64_t hash)
+{
+    ifstream file(filePath, ios::binary | ios::ate);
+
+    if (!file)
+    {
+        return 0;
+    }
+
+    uint64_t length = (uint64_t) file.tellg();
+    hash = Checksum::fnv1a(&length, sizeof(length), hash);
+
+    vector<char> block((size_t) min<uint64_t>(length, sampleBytes));
+
+    file.seekg(0);
+    file.read(block.data(), block.size());
+    hash = Checksum::fnv1a(block.data(), (size_t) file.gcount(), hash);
+
+    file.clear();
+    file.seekg((streamoff) (length - block.size()));
+    file.read(block.data(), block.size());
+    hash = Checksum::fnv1a(block.data(), (size_t) file.gcount(), hash);
+
+    return hash;
+}
+
+bool DetectionCache::load(string filePath, uint64_t key, Size& imageSize, vector<View>& views, bool& complete)
+{
+    CalibrationFile file;
+
+    if (key == 0 || !file.read(filePath) || !file.hasSection(CalibrationFile::detectionSection))
+    {
+        return false;
+    }
+
+    vector<char> payload = file.getSection(CalibrationFile::detectionSection);
+    size_t offset = 0;
+
+    uint64_t storedKey = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    uint8_t searched = 0;
+    uint32_t count = 0;
+
+    if (!CalibrationFile::take(payload, offset, storedKey)
+        || storedKey != key
+        || !CalibrationFile::take(payload, offset, width)
+        || !CalibrationFile::take(payload, offset, height)
+        || !CalibrationFile::take(payload, offset, searched)
+        || !CalibrationFile::take(payload, offset, count))
+    {
+        return false;
+    }
+
+    vector<View> loaded(count);
+
+    for (View& view : loaded)
+    {
+        if (!CalibrationFile::take(payload, offset, view.frame) || !CalibrationFile::takePoints(payload, offset, view.corners))
+        {
+            return false;
+        }
+    }
+
+    imageSize = Size(width, height);
+    views.swap(loaded);
+    complete = searched != 0;
+
+    return true;
+}
+
+bool DetectionCache::store(string filePath, uint64_t key, Size imageSize, const vector<View>& views, bool complete)
+{
+    if (key == 0)
+    {
+        return false;
+    }
+
+    vector<char> payload;
+
+    CalibrationFile::put(payload, key);
+    CalibrationFile::put(payload, (int32_t) imageSize.width);
+    CalibrationFile::put(payload, (int32_t) imageSize.height);
+    CalibrationFile::put(payload, (uint8_t) complete);
+    CalibrationFile::put(payload, (uint32_t) views.size());
+
+    for (const View& view : views)
+    {
+        CalibrationFile::put(payload, view.frame);
+        CalibrationFile::putPoints(payload, view.corners);
+    }
+
+    CalibrationFile file;
+    file.setSection(CalibrationFile::detectionSection, payload);
+
+    return file.write(filePath);
+}
@@ -0,0 +1,65 @@
+/**
+ * DetectionCache.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module persists the pattern corners found in a calibration video, so
+ * that trying other calibration flags on the same video skips straight to
+ * calibrateCamera instead of searching every frame again. The cache is a
+ * .calib style file holding a detection section, keyed by a hash of the video
+ * and of the settings that decide which corners are found.
+ */
+
+#ifndef DETECTIONCACHE_H
+#define DETECTIONCACHE_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DetectionCache
+{
+    /**
+     * Corners found on one source frame.
+     */
+    struct View
+    {
+        uint32_t frame;
+        std::vector<cv::Point2f> corners;
+    };
+
+    /**
+     * Hash a video file from its size and its first and last blocks, which
+     * tells re-encoded or trimmed videos apart without reading the whole file.
+     * @param  filePath Video file.
+     * @param  hash     Hash so far, such as of the detection settings.
+     * @return          Key, 0 if the file could not be read.
+     */
+    uint64_t videoKey(std::string filePath, uint64_t hash);
+
+    /**
+     * Load detections from a cache file.
+     * @param  filePath  Cache file.
+     * @param  key       Expected key.
+     * @param  imageSize Output frame size.
+     * @param  views     Output detections in frame order.
+     * @param  complete  Output if every frame of the video was searched.
+     * @return           False if the file is missing, corrupt or stale.
+     */
+    bool load(std::string filePath, uint64_t key, cv::Size& imageSize, std::vector<View>& views, bool& complete);
+
+    /**
+     * Write detections to a cache file, replacing any existing file.
+     * @param  filePath  Cache file.
+     * @param  key       Key of the detections.
+     * @param  imageSize Frame size.
+     * @param  views     Detections in frame order.
+     * @param  complete  If every frame of the video was searched.
+     * @return           Boolean indication of success.
+     */
+    bool store(std::string filePath, uint64_t key, cv::Size imageSize, const std::vector<View>& views, bool complete);
+}
+
+#endif /* DETECTIONCACHE_H */
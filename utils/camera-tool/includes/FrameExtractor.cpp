@@ -0,0 +1,121 @@
+/**
+ * FrameExtractor.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "FrameExtractor.hpp"
+#include "BoundedQueue.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    struct EncodeTask
+    {
+        unsigned int number;
+        Mat frame;
+    };
+}
+
+FrameExtractor::FrameExtractor()
+:threads(0),
+fps(0),
+frameCount(0)
+{
+
+}
+
+void FrameExtractor::setThreads(unsigned int count)
+{
+    this->threads = count;
+}
+
+double FrameExtractor::getFps()
+{
+    return this->fps;
+}
+
+unsigned int FrameExtractor::getFrameCount()
+{
+    return this->frameCount;
+}
+
+bool FrameExtractor::extract(string src, string dst, function<void(unsigned int)> progress)
+{
+    VideoCapture video(src);
+
+    if (!video.isOpened())
+    {
+        return false;
+    }
+
+    this->fps = video.get(CAP_PROP_FPS);
+    this->frameCount = 0;
+
+    if (dst.empty() || (dst[dst.length() - 1] != '/' && dst[dst.length() - 1] != '\\'))
+    {
+        dst += "/";
+    }
+
+    unsigned int encoderCount = this->threads > 0 ? this->threads : max(thread::hardware_concurrency(), 1u);
+
+    BoundedQueue<EncodeTask> tasks(encoderCount * 2);
+    atomic<bool> failed(false);
+    vector<thread> encoders;
+
+    for (unsigned int i = 0; i < encoderCount; i++)
+    {
+        encoders.emplace_back([&]()
+        {
+            EncodeTask task;
+
+            while (tasks.pop(task))
+            {
+                if (!imwrite(dst + to_string(task.number) + ".jpg", task.frame))
+                {
+                    failed = true;
+                }
+            }
+        });
+    }
+
+    while (true)
+    {
+        // Fresh buffer for every frame as queued frames are still encoding.
+        Mat frame;
+        video >> frame;
+
+        if (frame.empty())
+        {
+            break;
+        }
+
+        this->frameCount++;
+        tasks.push({ this->frameCount, frame });
+
+        if (progress)
+        {
+            progress(this->frameCount);
+        }
+    }
+
+    tasks.close();
+
+    for (thread& encoder : encoders)
+    {
+        encoder.join();
+    }
+
+    return !failed;
+}
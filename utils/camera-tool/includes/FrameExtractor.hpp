@@ -0,0 +1,58 @@
+/**
+ * FrameExtractor.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module extracts every frame of a video into numbered JPEG files. One
+ * thread decodes while a pool of threads encodes and writes the images, as
+ * JPEG encoding is far slower than decoding.
+ */
+
+#ifndef FRAMEEXTRACTOR_H
+#define FRAMEEXTRACTOR_H
+
+#include <opencv2/core.hpp>
+
+#include <string>
+#include <functional>
+
+class FrameExtractor
+{
+private:
+    unsigned int threads;
+    double fps;
+    unsigned int frameCount;
+
+public:
+    FrameExtractor();
+
+    /**
+     * Set the number of encoding threads.
+     * @param count Thread count, 0 uses the hardware concurrency.
+     */
+    void setThreads(unsigned int count);
+
+    /**
+     * Extract the frames of a video as 1.jpg to N.jpg in a directory.
+     * @param  src      Source video file.
+     * @param  dst      Destination directory.
+     * @param  progress Optional callback run on the calling thread with the
+     *                  number of frames decoded so far.
+     * @return          Boolean indication of success.
+     */
+    bool extract(std::string src, std::string dst, std::function<void(unsigned int)> progress = nullptr);
+
+    /**
+     * Get the frame rate of the last extracted video.
+     * @return Frames per second.
+     */
+    double getFps();
+
+    /**
+     * Get the number of frames in the last extracted video.
+     * @return Frame count.
+     */
+    unsigned int getFrameCount();
+};
+
+#endif /* FRAMEEXTRACTOR_H */
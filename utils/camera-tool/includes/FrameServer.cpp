@@ -0,0 +1,329 @@
+/**
+ * FrameServer.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "FrameServer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include <opencv2/imgcodecs.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    // Forward jumps up to this many frames decode through instead of seeking,
+    // since a seek restarts decoding from the previous keyframe anyway.
+    const size_t maxDecodeThrough = 48;
+
+    size_t frameBytes(const Mat& frame)
+    {
+        return frame.total() * frame.elemSize();
+    }
+}
+
+FrameServer::FrameServer()
+:position(0),
+frameCount(0),
+fps(0),
+cacheBytes(0),
+cacheBudget(512 * 1024 * 1024),
+hits(0),
+misses(0),
+lastIndex(0),
+direction(0),
+readAhead(16),
+generation(0),
+readAheadPending(false),
+stopping(false)
+{
+    this->reader = thread(&FrameServer::runReadAhead, this);
+}
+
+FrameServer::FrameServer(string filePath)
+:FrameServer()
+{
+    this->open(filePath);
+}
+
+FrameServer::~FrameServer()
+{
+    {
+        lock_guard<mutex> lock(this->cacheMutex);
+        this->stopping = true;
+        this->wake.notify_all();
+    }
+
+    this->reader.join();
+}
+
+bool FrameServer::open(string filePath)
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+
+    this->generation++;
+    this->cache.clear();
+    this->cacheIndex.clear();
+    this->cacheBytes = 0;
+    this->pool.clear();
+    this->position = 0;
+    this->direction = 0;
+
+    if (this->video.open(filePath))
+    {
+        this->frameCount = (size_t) max(this->video.get(CAP_PROP_FRAME_COUNT), 0.0);
+        this->fps = this->video.get(CAP_PROP_FPS);
+
+        return true;
+    }
+
+    this->frameCount = 0;
+    this->fps = 0;
+
+    return false;
+}
+
+bool FrameServer::isOpened()
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+    return this->video.isOpened();
+}
+
+void FrameServer::setCacheBudget(size_t bytes)
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+    this->cacheBudget = bytes;
+    this->evict();
+}
+
+void FrameServer::setReadAhead(size_t frames)
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+    this->readAhead = frames;
+}
+
+size_t FrameServer::getFrameCount()
+{
+    return this->frameCount;
+}
+
+double FrameServer::getFps()
+{
+    return this->fps;
+}
+
+size_t FrameServer::getHits()
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+    return this->hits;
+}
+
+size_t FrameServer::getMisses()
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+    return this->misses;
+}
+
+size_t FrameServer::getCacheBytes()
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+    return this->cacheBytes;
+}
+
+bool FrameServer::decode(size_t index, Mat& frame)
+{
+    if (!this->video.isOpened())
+    {
+        return false;
+    }
+
+    if (index < this->position || index - this->position > maxDecodeThrough)
+    {
+        // The backend seeks to the previous keyframe and decodes forward.
+        if (!this->video.set(CAP_PROP_POS_FRAMES, (double) index))
+        {
+            this->position = SIZE_MAX;
+            return false;
+        }
+
+        this->position = index;
+    }
+
+    while (this->position < index)
+    {
+        if (!this->video.grab())
+        {
+            this->position = SIZE_MAX;
+            return false;
+        }
+
+        this->position++;
+    }
+
+    // Decode into a recycled buffer, read reuses it when the size matches.
+    if (!this->pool.empty())
+    {
+        frame = this->pool.back();
+        this->pool.pop_back();
+    }
+
+    if (this->video.read(frame) && !frame.empty())
+    {
+        this->position++;
+        return true;
+    }
+
+    // The capture state is unknown after a failure, so the next request seeks.
+    this->position = SIZE_MAX;
+    return false;
+}
+
+void FrameServer::insert(size_t index, const Mat& frame)
+{
+    this->cache.emplace_front(index, frame);
+    this->cacheIndex[index] = this->cache.begin();
+    this->cacheBytes += frameBytes(frame);
+
+    this->evict();
+}
+
+void FrameServer::evict()
+{
+    while (this->cacheBytes > this->cacheBudget && !this->cache.empty())
+    {
+        Mat& frame = this->cache.back().second;
+        this->cacheBytes -= frameBytes(frame);
+
+        // Only recycle buffers nobody outside the cache still references.
+        if (frame.u && frame.u->refcount == 1 && this->pool.size() < this->readAhead + 2)
+        {
+            this->pool.push_back(frame);
+        }
+
+        this->cacheIndex.erase(this->cache.back().first);
+        this->cache.pop_back();
+    }
+}
+
+void FrameServer::runReadAhead()
+{
+    unique_lock<mutex> lock(this->cacheMutex);
+
+    while (!this->stopping)
+    {
+        this->wake.wait(lock, [this]() { return this->stopping || this->readAheadPending; });
+        this->readAheadPending = false;
+
+        size_t generation = this->generation;
+        size_t from = this->lastIndex;
+        size_t count = this->readAhead;
+        vector<size_t> indices;
+
+        // Backward read-ahead is decoded in ascending order so it costs one
+        // seek rather than one per frame.
+        if (this->direction > 0)
+        {
+            for (size_t i = 1; i <= count; i++)
+            {
+                if (this->frameCount == 0 || from + i < this->frameCount)
+                {
+                    indices.push_back(from + i);
+                }
+            }
+        }
+        else if (this->direction < 0)
+        {
+            for (size_t i = min(count, from); i >= 1; i--)
+            {
+                indices.push_back(from - i);
+            }
+        }
+
+        for (size_t index : indices)
+        {
+            if (this->stopping || generation != this->generation)
+            {
+                break;
+            }
+
+            if (this->cacheIndex.count(index))
+            {
+                continue;
+            }
+
+            Mat frame;
+
+            if (!this->decode(index, frame))
+            {
+                break;
+            }
+
+            this->insert(index, frame);
+
+            // Let waiting requests in between frames.
+            lock.unlock();
+            this_thread::yield();
+            lock.lock();
+        }
+    }
+}
+
+bool FrameServer::getFrame(size_t index, Mat& frame)
+{
+    lock_guard<mutex> lock(this->cacheMutex);
+
+    this->generation++;
+
+    if (index == this->lastIndex + 1)
+    {
+        this->direction = 1;
+    }
+    else if (index + 1 == this->lastIndex)
+    {
+        this->direction = -1;
+    }
+
+    this->lastIndex = index;
+
+    auto it = this->cacheIndex.find(index);
+
+    if (it != this->cacheIndex.end())
+    {
+        this->hits++;
+        this->cache.splice(this->cache.begin(), this->cache, it->second);
+        frame = it->second->second;
+    }
+    else
+    {
+        this->misses++;
+
+        Mat decoded;
+
+        if (!this->decode(index, decoded))
+        {
+            return false;
+        }
+
+        this->insert(index, decoded);
+        frame = decoded;
+    }
+
+    if (this->readAhead > 0 && this->direction != 0)
+    {
+        this->readAheadPending = true;
+        this->wake.notify_one();
+    }
+
+    return true;
+}
+
+bool FrameServer::getEncoded(size_t index, vector<uchar>& buffer, string extension)
+{
+    Mat frame;
+
+    return this->getFrame(index, frame) && imencode(extension, frame, buffer);
+}
@@ -0,0 +1,144 @@
+/**
+ * FrameServer.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module decodes requested frames of a video on demand, so annotation
+ * can start without extracting every frame to disk first. Decoded frames are
+ * kept in a least recently used cache bounded by a memory budget, and a
+ * background thread reads ahead in the direction the user is stepping so
+ * frame by frame navigation is served from memory.
+ */
+
+#ifndef FRAMESERVER_H
+#define FRAMESERVER_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class FrameServer
+{
+private:
+    typedef std::list< std::pair<size_t, cv::Mat> > FrameList;
+
+    cv::VideoCapture video;
+    size_t position;        // Index of the frame the next read returns, SIZE_MAX if unknown
+    size_t frameCount;
+    double fps;
+
+    FrameList cache;        // Most recent first
+    std::unordered_map<size_t, FrameList::iterator> cacheIndex;
+    size_t cacheBytes;
+    size_t cacheBudget;
+    std::vector<cv::Mat> pool;  // Evicted buffers reused for decoding
+
+    size_t hits;
+    size_t misses;
+
+    size_t lastIndex;
+    int direction;          // 1 forward, -1 backward, 0 unknown
+    size_t readAhead;
+    size_t generation;      // Bumped by every request to cancel stale read-ahead
+    bool readAheadPending;
+    bool stopping;
+
+    std::mutex cacheMutex;
+    std::condition_variable wake;
+    std::thread reader;
+
+    bool decode(size_t index, cv::Mat& frame);
+    void insert(size_t index, const cv::Mat& frame);
+    void evict();
+    void runReadAhead();
+
+public:
+    FrameServer();
+    FrameServer(std::string filePath);
+    ~FrameServer();
+
+    FrameServer(const FrameServer&) = delete;
+    FrameServer& operator=(const FrameServer&) = delete;
+
+    /**
+     * Open a video file, clearing the cache.
+     * @param  filePath Video file.
+     * @return          Boolean indication of success.
+     */
+    bool open(std::string filePath);
+
+    /**
+     * Check if a video is open.
+     * @return Boolean.
+     */
+    bool isOpened();
+
+    /**
+     * Set the memory budget of the frame cache.
+     * @param bytes Maximum bytes of decoded frames kept.
+     */
+    void setCacheBudget(size_t bytes);
+
+    /**
+     * Set how many frames are decoded ahead in the direction of navigation.
+     * @param frames Read-ahead length, 0 disables it.
+     */
+    void setReadAhead(size_t frames);
+
+    /**
+     * Get the number of frames reported by the container.
+     * @return Frame count.
+     */
+    size_t getFrameCount();
+
+    /**
+     * Get the frame rate of the video.
+     * @return Frames per second.
+     */
+    double getFps();
+
+    /**
+     * Get the number of requests answered from the cache.
+     * @return Hit count.
+     */
+    size_t getHits();
+
+    /**
+     * Get the number of requests that had to be decoded.
+     * @return Miss count.
+     */
+    size_t getMisses();
+
+    /**
+     * Get the bytes of decoded frames currently cached.
+     * @return Cache size in bytes.
+     */
+    size_t getCacheBytes();
+
+    /**
+     * Get a decoded frame. The returned Mat shares the cached buffer and must
+     * not be modified.
+     * @param  index Zero based frame index.
+     * @param  frame Output BGR frame.
+     * @return       Boolean indication of success.
+     */
+    bool getFrame(size_t index, cv::Mat& frame);
+
+    /**
+     * Get a frame encoded as an image file.
+     * @param  index     Zero based frame index.
+     * @param  buffer    Output encoded bytes.
+     * @param  extension Image format extension.
+     * @return           Boolean indication of success.
+     */
+    bool getEncoded(size_t index, std::vector<uchar>& buffer, std::string extension = ".jpg");
+};
+
+#endif /* FRAMESERVER_H */
@@ -0,0 +1,378 @@
+/**
+ * FusedTransform.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "FusedTransform.hpp"
+
+#include <math.h>
+#include <float.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FUSEDTRANSFORM_X86
+#include <immintrin.h>
+#endif
+
+#if defined(FUSEDTRANSFORM_X86) && defined(__GNUC__)
+#define TARGET_AVX __attribute__((target("avx")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define TARGET_AVX
+#define TARGET_SSE41
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    // Same fixed iteration count used by undistortPoints.
+    const int undistortIterations = 5;
+
+    /**
+     * Vector kernels for the radial only model that runCalibration produces
+     * (tangential and rational terms fixed at zero). They perform the same
+     * double precision operations in the same order as toVirtual, without
+     * FMA contraction, so results match the scalar path exactly. Each kernel
+     * processes as many whole vectors as fit and returns how many points it
+     * consumed through processed.
+     */
+#ifdef FUSEDTRANSFORM_X86
+    TARGET_AVX
+    size_t radialAvx(const FusedTransform& t, const Point2f* in, Point2f* out, size_t n, size_t& processed)
+    {
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1);
+        const __m256d minusOne = _mm256_set1_pd(-1);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256d eps = _mm256_set1_pd(FLT_EPSILON);
+        const __m256d fx = _mm256_set1_pd(t.fx), fy = _mm256_set1_pd(t.fy);
+        const __m256d cx = _mm256_set1_pd(t.cx), cy = _mm256_set1_pd(t.cy);
+        const __m256d ifx = _mm256_set1_pd(t.ifx), ify = _mm256_set1_pd(t.ify);
+        const __m256d k1 = _mm256_set1_pd(t.k[0]), k2 = _mm256_set1_pd(t.k[1]), k3 = _mm256_set1_pd(t.k[4]);
+        const __m256d ox = _mm256_set1_pd(t.originX), oy = _mm256_set1_pd(t.originY);
+        const __m256d scale = _mm256_set1_pd(t.scale);
+        __m256d h[9];
+
+        for (int j = 0; j < 9; j++)
+        {
+            h[j] = _mm256_set1_pd(t.h[j]);
+        }
+
+        size_t count = 0;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+            // Load four interleaved points and split them into x and y
+            // vectors, ordered as points 0, 2, 1, 3.
+            __m256 p = _mm256_loadu_ps((const float*) (in + i));
+            __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(p));
+            __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(p, 1));
+            __m256d x = _mm256_unpacklo_pd(lo, hi);
+            __m256d y = _mm256_unpackhi_pd(lo, hi);
+
+            __m256d invalid = _mm256_or_pd(_mm256_cmp_pd(x, zero, _CMP_LT_OQ), _mm256_cmp_pd(y, zero, _CMP_LT_OQ));
+
+            __m256d x0 = _mm256_mul_pd(_mm256_sub_pd(x, cx), ifx);
+            __m256d y0 = _mm256_mul_pd(_mm256_sub_pd(y, cy), ify);
+            __m256d xd = x0;
+            __m256d yd = y0;
+
+            for (int j = 0; j < undistortIterations; j++)
+            {
+                __m256d r2 = _mm256_add_pd(_mm256_mul_pd(xd, xd), _mm256_mul_pd(yd, yd));
+                __m256d den = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(k3, r2), k2), r2), k1);
+                den = _mm256_add_pd(one, _mm256_mul_pd(den, r2));
+                __m256d icdist = _mm256_div_pd(one, den);
+                xd = _mm256_mul_pd(x0, icdist);
+                yd = _mm256_mul_pd(y0, icdist);
+            }
+
+            xd = _mm256_add_pd(_mm256_mul_pd(xd, fx), cx);
+            yd = _mm256_add_pd(_mm256_mul_pd(yd, fy), cy);
+
+            invalid = _mm256_or_pd(invalid, _mm256_or_pd(_mm256_cmp_pd(xd, zero, _CMP_LT_OQ), _mm256_cmp_pd(yd, zero, _CMP_LT_OQ)));
+
+            __m256d w = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(h[6], xd), _mm256_mul_pd(h[7], yd)), h[8]);
+            __m256d finite = _mm256_cmp_pd(_mm256_andnot_pd(signMask, w), eps, _CMP_GT_OQ);
+            w = _mm256_div_pd(one, w);
+
+            __m256d u = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(h[0], xd), _mm256_mul_pd(h[1], yd)), h[2]), w);
+            __m256d v = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(h[3], xd), _mm256_mul_pd(h[4], yd)), h[5]), w);
+            u = _mm256_and_pd(u, finite);
+            v = _mm256_and_pd(v, finite);
+
+            u = _mm256_mul_pd(_mm256_sub_pd(u, ox), scale);
+            v = _mm256_mul_pd(_mm256_sub_pd(v, oy), scale);
+            u = _mm256_blendv_pd(u, minusOne, invalid);
+            v = _mm256_blendv_pd(v, minusOne, invalid);
+
+            // Interleave back to points 0, 1 and 2, 3.
+            _mm_storeu_ps((float*) (out + i), _mm256_cvtpd_ps(_mm256_unpacklo_pd(u, v)));
+            _mm_storeu_ps((float*) (out + i + 2), _mm256_cvtpd_ps(_mm256_unpackhi_pd(u, v)));
+
+            int mask = _mm256_movemask_pd(invalid);
+            count += 4 - ((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3));
+        }
+
+        processed = i;
+        return count;
+    }
+
+    TARGET_SSE41
+    size_t radialSse41(const FusedTransform& t, const Point2f* in, Point2f* out, size_t n, size_t& processed)
+    {
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1);
+        const __m128d minusOne = _mm_set1_pd(-1);
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        const __m128d eps = _mm_set1_pd(FLT_EPSILON);
+        const __m128d fx = _mm_set1_pd(t.fx), fy = _mm_set1_pd(t.fy);
+        const __m128d cx = _mm_set1_pd(t.cx), cy = _mm_set1_pd(t.cy);
+        const __m128d ifx = _mm_set1_pd(t.ifx), ify = _mm_set1_pd(t.ify);
+        const __m128d k1 = _mm_set1_pd(t.k[0]), k2 = _mm_set1_pd(t.k[1]), k3 = _mm_set1_pd(t.k[4]);
+        const __m128d ox = _mm_set1_pd(t.originX), oy = _mm_set1_pd(t.originY);
+        const __m128d scale = _mm_set1_pd(t.scale);
+        __m128d h[9];
+
+        for (int j = 0; j < 9; j++)
+        {
+            h[j] = _mm_set1_pd(t.h[j]);
+        }
+
+        size_t count = 0;
+        size_t i = 0;
+
+        for (; i + 2 <= n; i += 2)
+        {
+            // Load two interleaved points and split them into x and y.
+            __m128 p = _mm_loadu_ps((const float*) (in + i));
+            __m128d lo = _mm_cvtps_pd(p);
+            __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(p, p));
+            __m128d x = _mm_unpacklo_pd(lo, hi);
+            __m128d y = _mm_unpackhi_pd(lo, hi);
+
+            __m128d invalid = _mm_or_pd(_mm_cmplt_pd(x, zero), _mm_cmplt_pd(y, zero));
+
+            __m128d x0 = _mm_mul_pd(_mm_sub_pd(x, cx), ifx);
+            __m128d y0 = _mm_mul_pd(_mm_sub_pd(y, cy), ify);
+            __m128d xd = x0;
+            __m128d yd = y0;
+
+            for (int j = 0; j < undistortIterations; j++)
+            {
+                __m128d r2 = _mm_add_pd(_mm_mul_pd(xd, xd), _mm_mul_pd(yd, yd));
+                __m128d den = _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(k3, r2), k2), r2), k1);
+                den = _mm_add_pd(one, _mm_mul_pd(den, r2));
+                __m128d icdist = _mm_div_pd(one, den);
+                xd = _mm_mul_pd(x0, icdist);
+                yd = _mm_mul_pd(y0, icdist);
+            }
+
+            xd = _mm_add_pd(_mm_mul_pd(xd, fx), cx);
+            yd = _mm_add_pd(_mm_mul_pd(yd, fy), cy);
+
+            invalid = _mm_or_pd(invalid, _mm_or_pd(_mm_cmplt_pd(xd, zero), _mm_cmplt_pd(yd, zero)));
+
+            __m128d w = _mm_add_pd(_mm_add_pd(_mm_mul_pd(h[6], xd), _mm_mul_pd(h[7], yd)), h[8]);
+            __m128d finite = _mm_cmpgt_pd(_mm_andnot_pd(signMask, w), eps);
+            w = _mm_div_pd(one, w);
+
+            __m128d u = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(h[0], xd), _mm_mul_pd(h[1], yd)), h[2]), w);
+            __m128d v = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(h[3], xd), _mm_mul_pd(h[4], yd)), h[5]), w);
+            u = _mm_and_pd(u, finite);
+            v = _mm_and_pd(v, finite);
+
+            u = _mm_mul_pd(_mm_sub_pd(u, ox), scale);
+            v = _mm_mul_pd(_mm_sub_pd(v, oy), scale);
+            u = _mm_blendv_pd(u, minusOne, invalid);
+            v = _mm_blendv_pd(v, minusOne, invalid);
+
+            __m128 lo32 = _mm_cvtpd_ps(_mm_unpacklo_pd(u, v));
+            __m128 hi32 = _mm_cvtpd_ps(_mm_unpackhi_pd(u, v));
+            _mm_storeu_ps((float*) (out + i), _mm_movelh_ps(lo32, hi32));
+
+            int mask = _mm_movemask_pd(invalid);
+            count += 2 - ((mask & 1) + (mask >> 1));
+        }
+
+        processed = i;
+        return count;
+    }
+#endif
+
+    typedef size_t (*VectorKernel)(const FusedTransform& t, const Point2f* in, Point2f* out, size_t n, size_t& processed);
+
+    /**
+     * Picks the widest vector kernel supported by the running CPU.
+     * @return Kernel, or nullptr if only the scalar path is available.
+     */
+    VectorKernel selectKernel()
+    {
+#ifdef FUSEDTRANSFORM_X86
+        if (checkHardwareSupport(CV_CPU_AVX))
+        {
+            return radialAvx;
+        }
+
+        if (checkHardwareSupport(CV_CPU_SSE4_1))
+        {
+            return radialSse41;
+        }
+#endif
+        return nullptr;
+    }
+}
+
+bool FusedTransform::compile(const Mat& cameraMatrix, const Mat& distCoeffs, const Mat& homography, double scaleFactor)
+{
+    this->valid = false;
+
+    if (cameraMatrix.rows != 3 || cameraMatrix.cols != 3 ||
+        homography.rows != 3 || homography.cols != 3 ||
+        distCoeffs.total() < 4 || scaleFactor <= 0)
+    {
+        return false;
+    }
+
+    Mat A, D, H;
+    cameraMatrix.convertTo(A, CV_64F);
+    distCoeffs.convertTo(D, CV_64F);
+    homography.convertTo(H, CV_64F);
+
+    this->fx = A.at<double>(0, 0);
+    this->fy = A.at<double>(1, 1);
+    this->cx = A.at<double>(0, 2);
+    this->cy = A.at<double>(1, 2);
+
+    if (this->fx == 0 || this->fy == 0)
+    {
+        return false;
+    }
+
+    this->ifx = 1. / this->fx;
+    this->ify = 1. / this->fy;
+
+    for (int i = 0; i < 8; i++)
+    {
+        this->k[i] = i < (int) D.total() ? D.at<double>(i) : 0;
+    }
+
+    for (int i = 0; i < 9; i++)
+    {
+        this->h[i] = H.at<double>(i / 3, i % 3);
+    }
+
+    this->originX = 0;
+    this->originY = 0;
+    this->scale = scaleFactor;
+    this->valid = true;
+
+    return true;
+}
+
+void FusedTransform::setOrigin(const Point2f& origin)
+{
+    this->originX = origin.x;
+    this->originY = origin.y;
+}
+
+bool FusedTransform::toVirtual(double x, double y, double& u, double& v) const
+{
+    if (!this->valid || x < 0 || y < 0)
+    {
+        return false;
+    }
+
+    // Iteratively remove distortion in normalised camera coordinates.
+    double x0 = (x - this->cx) * this->ifx;
+    double y0 = (y - this->cy) * this->ify;
+    double xd = x0;
+    double yd = y0;
+
+    for (int j = 0; j < undistortIterations; j++)
+    {
+        double r2 = xd * xd + yd * yd;
+        double icdist = (1 + ((this->k[7] * r2 + this->k[6]) * r2 + this->k[5]) * r2) /
+                        (1 + ((this->k[4] * r2 + this->k[1]) * r2 + this->k[0]) * r2);
+        double deltaX = 2 * this->k[2] * xd * yd + this->k[3] * (r2 + 2 * xd * xd);
+        double deltaY = this->k[2] * (r2 + 2 * yd * yd) + 2 * this->k[3] * xd * yd;
+        xd = (x0 - deltaX) * icdist;
+        yd = (y0 - deltaY) * icdist;
+    }
+
+    // Back to pixels with the same camera matrix.
+    xd = xd * this->fx + this->cx;
+    yd = yd * this->fy + this->cy;
+
+    if (xd < 0 || yd < 0)
+    {
+        return false;
+    }
+
+    double w = this->h[6] * xd + this->h[7] * yd + this->h[8];
+
+    if (fabs(w) > FLT_EPSILON)
+    {
+        w = 1. / w;
+        u = (this->h[0] * xd + this->h[1] * yd + this->h[2]) * w;
+        v = (this->h[3] * xd + this->h[4] * yd + this->h[5]) * w;
+    }
+    else
+    {
+        u = 0;
+        v = 0;
+    }
+
+    return true;
+}
+
+Point2f FusedTransform::apply(const Point2f& point) const
+{
+    double u, v;
+
+    if (this->toVirtual(point.x, point.y, u, v))
+    {
+        return Point2f((float) ((u - this->originX) * this->scale), (float) ((v - this->originY) * this->scale));
+    }
+
+    return Point2f(-1, -1);
+}
+
+bool FusedTransform::isRadial() const
+{
+    return this->k[2] == 0 && this->k[3] == 0 && this->k[5] == 0 && this->k[6] == 0 && this->k[7] == 0;
+}
+
+size_t FusedTransform::apply(const Point2f* in, Point2f* out, size_t n) const
+{
+    static const VectorKernel kernel = selectKernel();
+
+    size_t count = 0;
+    size_t i = 0;
+
+    if (this->valid && kernel && this->isRadial())
+    {
+        count = kernel(*this, in, out, n, i);
+    }
+
+    // Scalar path for other distortion models and the remaining tail.
+    for (; i < n; i++)
+    {
+        double u, v;
+
+        if (this->toVirtual(in[i].x, in[i].y, u, v))
+        {
+            out[i] = Point2f((float) ((u - this->originX) * this->scale), (float) ((v - this->originY) * this->scale));
+            count++;
+        }
+        else
+        {
+            out[i] = Point2f(-1, -1);
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,84 @@
+/**
+ * FusedTransform.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module flattens a lens calibration, a perspective calibration, an
+ * origin and a scale factor into one plain struct, so that image points can be
+ * converted to real world coordinates in a single pass without going through
+ * the generic OpenCV point functions.
+ */
+
+#ifndef FUSEDTRANSFORM_H
+#define FUSEDTRANSFORM_H
+
+#include <opencv2/core.hpp>
+
+struct FusedTransform
+{
+    // Camera matrix terms and inverse focal lengths.
+    double fx, fy, cx, cy, ifx, ify;
+    // Distortion coefficients k1, k2, p1, p2, k3, k4, k5, k6.
+    double k[8];
+    // Row major perspective homography.
+    double h[9];
+    // Transformed origin and real world distance per pixel.
+    double originX, originY;
+    double scale;
+    bool valid;
+
+    /**
+     * Copies the calibration matrices into the struct.
+     * @param  cameraMatrix 3x3 lens camera matrix.
+     * @param  distCoeffs   Lens distortion coefficients (4 to 8 elements).
+     * @param  homography   3x3 perspective transformation.
+     * @param  scaleFactor  Real world distance per pixel.
+     * @return              Boolean indication of success.
+     */
+    bool compile(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, const cv::Mat& homography, double scaleFactor);
+
+    /**
+     * Set the origin in the top-down virtual image space.
+     * @param origin Transformed origin point.
+     */
+    void setOrigin(const cv::Point2f& origin);
+
+    /**
+     * Remove lens distortion and apply the homography to a point, giving the
+     * point in the top-down virtual image space.
+     * @param  x Image space x.
+     * @param  y Image space y.
+     * @param  u Virtual x.
+     * @param  v Virtual y.
+     * @return   If the point was valid.
+     */
+    bool toVirtual(double x, double y, double& u, double& v) const;
+
+    /**
+     * Transform an image space point to a real world coordinate.
+     * @param  point Image space point.
+     * @return       Real world coordinate, or (-1, -1) if invalid.
+     */
+    cv::Point2f apply(const cv::Point2f& point) const;
+
+    /**
+     * Check if the distortion model only has radial terms (k1, k2, k3), which
+     * is what LensCalibration produces with its default flags.
+     * @return Boolean.
+     */
+    bool isRadial() const;
+
+    /**
+     * Transform a batch of image space points to real world coordinates.
+     * Radial distortion models use a SIMD kernel chosen at runtime by CPU
+     * feature detection, with the scalar path as a fallback.
+     * @param  in  Image space points.
+     * @param  out Real world coordinates, may be the same buffer as in.
+     *             Invalid points are output as (-1, -1).
+     * @param  n   Number of points.
+     * @return     Number of valid points transformed.
+     */
+    size_t apply(const cv::Point2f* in, cv::Point2f* out, size_t n) const;
+};
+
+#endif /* FUSEDTRANSFORM_H */
@@ -8,6 +8,7 @@
 
 #include <math.h>
 #include <iostream>
+#include <algorithm>
 
 using namespace cv;
 using namespace std;
@@ -17,12 +18,15 @@ ImageDistance::ImageDistance(shared_ptr<LensCalibration> l, shared_ptr<Perspecti
     this->lens = l;
     this->perspective = p;
 	this->origin = Point2f(0, 0);
+    this->compile();
 }
 
 ImageDistance::ImageDistance(shared_ptr<LensCalibration> l, shared_ptr<PerspectiveCalibration> p, Point2f o)
 {
     this->lens = l;
     this->perspective = p;
+	this->origin = Point2f(0, 0);
+    this->compile();
     this->setOrigin(o);
 }
 
@@ -31,14 +35,39 @@ ImageDistance::~ImageDistance()
 
 }
 
+bool ImageDistance::compile()
+{
+    this->transform.valid = false;
+
+    if (this->lens && this->perspective && this->lens->isCalibrated() && this->perspective->isCalibrated())
+    {
+        return this->transform.compile
+        (
+            this->lens->getCameraMatrix(),
+            this->lens->getDistortionCoefficients(),
+            this->perspective->getTransform(),
+            this->perspective->getScaleFactor()
+        );
+    }
+
+    return false;
+}
+
 bool ImageDistance::isReady()
 {
-    return (this->lens && this->perspective && this->lens->isCalibrated() && this->lens->isMapped() && this->perspective->isCalibrated());
+    return (this->lens && this->perspective && this->lens->isCalibrated() && this->perspective->isCalibrated() && this->transform.valid);
 }
 
 Point2f ImageDistance::transformCoordinate(Point2f coordinate)
 {
-    return this->perspective->onPoint(this->lens->onPoint(coordinate));
+    double u, v;
+
+    if (this->transform.toVirtual(coordinate.x, coordinate.y, u, v))
+    {
+        return Point2f((float) u, (float) v);
+    }
+
+    return Point2f(-1, -1);
 }
 
 bool ImageDistance::setOrigin(Point2f origin)
@@ -50,6 +79,7 @@ bool ImageDistance::setOrigin(Point2f origin)
         if (transformedOrigin.x >= 0 && transformedOrigin.y >= 0)
         {
             this->origin = transformedOrigin;
+            this->transform.setOrigin(transformedOrigin);
             return true;
         }
     }
@@ -66,13 +96,22 @@ Point2f ImageDistance::getRealCoordinate(Point2f position)
 {
 	if (this->isReady())
 	{
-		Point2f virtualCoordinates(this->transformCoordinate(position) - this->origin);
-
-		return Point2f((float)(virtualCoordinates.x * this->perspective->getScaleFactor()), (float)(virtualCoordinates.y * this->perspective->getScaleFactor()));
+		return this->transform.apply(position);
 	}
 	return Point2f(-1, -1);
 }
 
+size_t ImageDistance::getRealCoordinates(const Point2f* positions, Point2f* coordinates, size_t n)
+{
+	if (!this->isReady())
+	{
+		fill(coordinates, coordinates + n, Point2f(-1, -1));
+		return 0;
+	}
+
+	return this->transform.apply(positions, coordinates, n);
+}
+
 double ImageDistance::getRealDistance(Point2f start, Point2f stop)
 {
 	if (this->isReady())
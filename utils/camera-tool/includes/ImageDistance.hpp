@@ -4,7 +4,9 @@
  * Licenced under the Artistic Licence 2.0.
  *
  * This module uses objects from the LensCalibration and PerspectiveCalibration
- * module to convert real distances from image distances.
+ * module to convert real distances from image distances. The calibrations are
+ * compiled into a FusedTransform on construction, so changes made to them
+ * afterwards are not picked up.
  */
 
 #ifndef IMAGEDISTANCE_H
@@ -12,6 +14,7 @@
 
 #include "LensCalibration.hpp"
 #include "PerspectiveCalibration.hpp"
+#include "FusedTransform.hpp"
 
 #include <memory>
 #include <opencv2/core.hpp>
@@ -23,6 +26,8 @@ private:
     cv::Point2f origin;
     std::shared_ptr<LensCalibration> lens;
     std::shared_ptr<PerspectiveCalibration> perspective;
+    FusedTransform transform;
+    bool compile();
     cv::Point2f transformCoordinate(cv::Point2f coordinate);
 
 public:
@@ -58,6 +63,17 @@ public:
      */
     cv::Point2f getRealCoordinate(cv::Point2f position);
 
+    /**
+     * Transforms a batch of image space coordinates into real world based
+     * coordinates in one call. Invalid points are output as (-1, -1).
+     * @param  positions   Image space coordinates.
+     * @param  coordinates Transformed coordinates, may be the same buffer as
+     *                     positions.
+     * @param  n           Number of coordinates.
+     * @return             Number of valid coordinates transformed.
+     */
+    size_t getRealCoordinates(const cv::Point2f* positions, cv::Point2f* coordinates, size_t n);
+
     /**
      * Calculates the real distance between the start and stop points with the
      * scale set in the perspective calibration object.
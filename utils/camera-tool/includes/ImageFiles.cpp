@@ -0,0 +1,111 @@
+/**
+ * ImageFiles.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "ImageFiles.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <opencv2/core.hpp>
+
+using namespace cv;
+using namespace std;
+
+bool ImageFiles::isImage(const string& filePath)
+{
+    static const char* extensions[] = { ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff" };
+
+    size_t dot = filePath.find_last_of('.');
+
+    if (dot == string::npos)
+    {
+        return false;
+    }
+
+    string extension = filePath.substr(dot);
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    return find(begin(extensions), end(extensions), extension) != end(extensions);
+}
+
+vector<string> ImageFiles::list(string source)
+{
+    // A plain directory takes every image file in it.
+    if (source.find_first_of("*?") == string::npos)
+    {
+        source = withSeparator(source) + "*";
+    }
+
+    vector<String> matches;
+    vector<string> files;
+
+    // glob throws when the directory does not exist.
+    try
+    {
+        glob(source, matches, false);
+    }
+    catch (const cv::Exception&)
+    {
+        return files;
+    }
+
+    for (const String& match : matches)
+    {
+        if (isImage(match))
+        {
+            files.push_back(match);
+        }
+    }
+
+    sort(files.begin(), files.end());
+
+    return files;
+}
+
+string ImageFiles::fileName(const string& filePath)
+{
+    size_t slash = filePath.find_last_of("/\\");
+
+    return slash == string::npos ? filePath : filePath.substr(slash + 1);
+}
+
+string ImageFiles::stem(const string& filePath)
+{
+    string name = fileName(filePath);
+
+    return name.substr(0, name.find_last_of('.'));
+}
+
+string ImageFiles::withSeparator(string directory)
+{
+    if (directory.empty() || (directory[directory.length() - 1] != '/' && directory[directory.length() - 1] != '\\'))
+    {
+        directory += "/";
+    }
+
+    return directory;
+}
+
+bool ImageFiles::makeDirectory(const string& directory)
+{
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+    struct _stat info;
+    return _stat(directory.c_str(), &info) == 0 && (info.st_mode & _S_IFDIR);
+#else
+    mkdir(directory.c_str(), 0755);
+    struct stat info;
+    return stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
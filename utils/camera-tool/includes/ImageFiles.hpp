@@ -0,0 +1,61 @@
+/**
+ * ImageFiles.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * Helpers for the modes that work through directories of images.
+ */
+
+#ifndef IMAGEFILES_H
+#define IMAGEFILES_H
+
+#include <string>
+#include <vector>
+
+namespace ImageFiles
+{
+    /**
+     * Check if a file has an image extension OpenCV can read.
+     * @param  filePath File name.
+     * @return          Boolean.
+     */
+    bool isImage(const std::string& filePath);
+
+    /**
+     * List the images in a directory, or matching a glob pattern, in sorted
+     * order.
+     * @param  source Directory or glob pattern.
+     * @return        Image file paths, empty if the directory does not exist.
+     */
+    std::vector<std::string> list(std::string source);
+
+    /**
+     * Get the file name part of a path.
+     * @param  filePath File path.
+     * @return          File name with extension.
+     */
+    std::string fileName(const std::string& filePath);
+
+    /**
+     * Get the file name part of a path without its extension.
+     * @param  filePath File path.
+     * @return          File name without extension.
+     */
+    std::string stem(const std::string& filePath);
+
+    /**
+     * Append a path separator to a directory if it does not end in one.
+     * @param  directory Directory path.
+     * @return           Directory path ending in a separator.
+     */
+    std::string withSeparator(std::string directory);
+
+    /**
+     * Create a directory if it does not already exist. Parents must exist.
+     * @param  directory Directory path.
+     * @return           If the directory exists afterwards.
+     */
+    bool makeDirectory(const std::string& directory);
+}
+
+#endif /* IMAGEFILES_H */
@@ -0,0 +1,239 @@
+/**
+ * ImageRectifier.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "ImageRectifier.hpp"
+#include "ImageFiles.hpp"
+#include "Checksum.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+using namespace cv;
+using namespace std;
+
+ImageRectifier::ImageRectifier(shared_ptr<LensCalibration> l, shared_ptr<PerspectiveCalibration> p)
+:lens(l),
+perspective(p),
+threads(0)
+{
+    string lensCache = this->lens ? this->lens->getMapCache() : "";
+
+    if (!lensCache.empty() && this->perspective)
+    {
+        // "<calibration>.maps" becomes "<calibration>.rectified-<key>.maps",
+        // where the key identifies the perspective, so rectifiers using one
+        // lens with different perspectives do not share a file.
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long) Checksum::fnv1a(this->perspective->getTransform()));
+
+        size_t dot = lensCache.find_last_of('.');
+        this->mapCachePath = lensCache.substr(0, dot) + ".rectified-" + key + lensCache.substr(dot);
+    }
+    else
+    {
+        this->mapCachePath = lensCache;
+    }
+}
+
+bool ImageRectifier::isReady()
+{
+    bool hasLens = this->lens && this->lens->isCalibrated();
+    bool hasPerspective = this->perspective && this->perspective->isCalibrated();
+
+    return (hasLens || hasPerspective)
+        && (!this->lens || hasLens)
+        && (!this->perspective || hasPerspective);
+}
+
+void ImageRectifier::setThreads(unsigned int count)
+{
+    this->threads = count;
+}
+
+void ImageRectifier::setMapCache(string filePath)
+{
+    this->mapCachePath = filePath;
+}
+
+bool ImageRectifier::generateMaps(Size size)
+{
+    if (!this->isReady() || size.area() <= 0)
+    {
+        return false;
+    }
+
+    lock_guard<mutex> lock(this->mapMutex);
+
+    if (size == this->mapSize)
+    {
+        return true;
+    }
+
+    // Without a lens calibration the identity camera turns the map into a
+    // plain inverse homography lookup.
+    Mat K = Mat::eye(3, 3, CV_64F);
+    Mat D;
+    Mat R;
+
+    if (this->lens)
+    {
+        if (size != this->lens->getImageSize())
+        {
+            return false;
+        }
+
+        this->lens->getCameraMatrix().convertTo(K, CV_64F);
+        D = this->lens->getDistortionCoefficients();
+    }
+
+    if (this->perspective)
+    {
+        // initUndistortRectifyMap looks up (K R)^-1 for each output pixel,
+        // so R = K^-1 H K makes that K^-1 H^-1, the undistorted pixel behind
+        // each top-down pixel in normalised coordinates.
+        Mat H;
+        this->perspective->getTransform().convertTo(H, CV_64F);
+        R = K.inv() * H * K;
+    }
+
+    uint64_t key = MapCache::key(K, D, R, size);
+
+    // Old maps may point into a read-only mapping, which must not be reused
+    // as the output buffer.
+    this->map1.release();
+    this->map2.release();
+    this->mapStorage.reset();
+
+    if (!this->mapCachePath.empty())
+    {
+        this->mapStorage = MapCache::load(this->mapCachePath, key, size, this->map1, this->map2);
+    }
+
+    if (!this->mapStorage)
+    {
+        initUndistortRectifyMap(K, D, R, K, size, CV_16SC2, this->map1, this->map2);
+
+        if (!this->mapCachePath.empty())
+        {
+            MapCache::store(this->mapCachePath, key, this->map1, this->map2);
+        }
+    }
+
+    this->mapSize = size;
+
+    return true;
+}
+
+Size ImageRectifier::getMapSize()
+{
+    return this->mapSize;
+}
+
+bool ImageRectifier::onImage(const Mat& rawImage, Mat& fixedImage) const
+{
+    if (this->map1.empty() || rawImage.size() != this->mapSize)
+    {
+        return false;
+    }
+
+    remap(rawImage, fixedImage, this->map1, this->map2, INTER_LINEAR);
+
+    return true;
+}
+
+bool ImageRectifier::onImage(string imagePath, Mat& fixedImage)
+{
+    Mat rawImage = imread(imagePath);
+
+    if (rawImage.empty())
+    {
+        cout << "Image could not be read: " << imagePath << endl;
+        return false;
+    }
+
+    if (!this->generateMaps(rawImage.size()))
+    {
+        cout << "Calibration does not match image: " << imagePath << endl;
+        return false;
+    }
+
+    return this->onImage(rawImage, fixedImage);
+}
+
+size_t ImageRectifier::onImages(string source, string dstDir)
+{
+    if (!this->isReady())
+    {
+        return 0;
+    }
+
+    vector<string> files = ImageFiles::list(source);
+    dstDir = ImageFiles::withSeparator(dstDir);
+
+    // Build the maps once up front so workers only read them.
+    for (const string& file : files)
+    {
+        Mat rawImage = imread(file);
+
+        if (!rawImage.empty())
+        {
+            this->generateMaps(rawImage.size());
+            break;
+        }
+    }
+
+    if (this->map1.empty())
+    {
+        return 0;
+    }
+
+    unsigned int workerCount = this->threads > 0 ? this->threads : max(thread::hardware_concurrency(), 1u);
+    workerCount = (unsigned int) min((size_t) workerCount, max(files.size(), (size_t) 1));
+
+    atomic<size_t> next(0);
+    atomic<size_t> written(0);
+    mutex output;
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            // Buffers are reused across images of the same size.
+            Mat rawImage;
+            Mat fixedImage;
+
+            for (size_t index = next++; index < files.size(); index = next++)
+            {
+                rawImage = imread(files[index]);
+
+                if (this->onImage(rawImage, fixedImage) && imwrite(dstDir + ImageFiles::fileName(files[index]), fixedImage))
+                {
+                    written++;
+                }
+                else
+                {
+                    lock_guard<mutex> lock(output);
+                    cout << "Image could not be rectified: " << files[index] << endl;
+                }
+            }
+        });
+    }
+
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    return written;
+}
@@ -0,0 +1,109 @@
+/**
+ * ImageRectifier.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module rectifies images to the top-down view in a single remap. The
+ * homography is folded into the rectification rotation of the undistortion
+ * map, so lens and perspective correction share one lookup and one
+ * interpolation instead of a remap followed by a warpPerspective. Either
+ * calibration may be omitted to apply only the other. Whole directories of
+ * frames can be rectified with the maps built once and shared by a pool of
+ * threads.
+ */
+
+#ifndef IMAGERECTIFIER_H
+#define IMAGERECTIFIER_H
+
+#include "LensCalibration.hpp"
+#include "PerspectiveCalibration.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <opencv2/core.hpp>
+
+class ImageRectifier
+{
+private:
+    std::shared_ptr<LensCalibration> lens;
+    std::shared_ptr<PerspectiveCalibration> perspective;
+
+    unsigned int threads;
+
+    cv::Size mapSize;
+    cv::Mat map1;
+    cv::Mat map2;
+    std::shared_ptr<MappedFile> mapStorage;  // Backs the maps when loaded from the cache
+    std::string mapCachePath;
+    std::mutex mapMutex;
+
+public:
+    ImageRectifier(std::shared_ptr<LensCalibration> l, std::shared_ptr<PerspectiveCalibration> p);
+
+    /**
+     * Check if the calibrations given are usable.
+     * @return True or False for readiness.
+     */
+    bool isReady();
+
+    /**
+     * Set the number of threads used to rectify multiple images.
+     * @param count Thread count, 0 uses the hardware concurrency.
+     */
+    void setThreads(unsigned int count);
+
+    /**
+     * Set the map cache file used by generateMaps. By default the lens
+     * calibration's cache is used for lens only maps, and the same path with
+     * ".rectified-<key>" inserted for fused maps, where the key is a hash of
+     * the perspective transform.
+     * @param filePath Cache file, empty to disable the cache.
+     */
+    void setMapCache(std::string filePath);
+
+    /**
+     * Build the fused maps for an image size. Lens calibrations only accept
+     * the size they were calibrated at. Safe to call from multiple threads,
+     * maps are only rebuilt when the size changes.
+     * @param  size Image size.
+     * @return      Boolean indication of success.
+     */
+    bool generateMaps(cv::Size size);
+
+    /**
+     * Get the size the current maps were built for.
+     * @return Map size, empty if no maps are built.
+     */
+    cv::Size getMapSize();
+
+    /**
+     * Rectify an image using the current maps. Safe to call from multiple
+     * threads once the maps are built.
+     * @param  rawImage   Image matching the map size.
+     * @param  fixedImage Output top-down image.
+     * @return            Boolean indication of success.
+     */
+    bool onImage(const cv::Mat& rawImage, cv::Mat& fixedImage) const;
+
+    /**
+     * Rectify an image file, building maps for its size when needed.
+     * @param  imagePath  Image file.
+     * @param  fixedImage Output top-down image.
+     * @return            Boolean indication of success.
+     */
+    bool onImage(std::string imagePath, cv::Mat& fixedImage);
+
+    /**
+     * Rectify every image in a directory, or matching a glob pattern, into a
+     * destination directory under the same file names. Maps are built from
+     * the first readable image and images of other sizes are skipped.
+     * @param  source Directory or glob pattern (e.g. a "*.jpg" pattern).
+     * @param  dstDir Existing destination directory.
+     * @return        Number of images written.
+     */
+    size_t onImages(std::string source, std::string dstDir);
+};
+
+#endif /* IMAGERECTIFIER_H */
@@ -6,7 +6,20 @@
 
 #include "LensCalibration.hpp"
 
+#include "BoundedQueue.hpp"
+#include "CalibrationFile.hpp"
+#include "Checksum.hpp"
+#include "ImageFiles.hpp"
+#include "PointBatch.hpp"
+
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #include <opencv2/core/utility.hpp>
 #include <opencv2/core/persistence.hpp>
@@ -20,14 +33,120 @@ using namespace std;
 
 namespace
 {
+    // Consecutive frames are searched by the same worker in chunks of this
+    // size, so each frame can start from the corners found on the one before.
+    // Chunks are split by frame position, keeping the results independent of
+    // the thread count.
+    const size_t trackChunk = 4;
+
+    // The board may move this many of its own widths between searched frames
+    // and still be found in the region around its last position.
+    const double trackPadding = 0.5;
+
+    // Frames are downscaled to this width before measuring sharpness, so the
+    // threshold means the same at any resolution.
+    const int sharpnessWidth = 640;
+
+    struct QueuedFrame
+    {
+        size_t index;
+        size_t frame;
+        Mat view;
+    };
+
+    /**
+     * Measure the sharpness of a frame as the variance of the Laplacian of a
+     * downscaled gray copy. Motion blurred frames score low.
+     * @param  view Colour frame.
+     * @return      Sharpness.
+     */
+    double measureSharpness(const Mat& view)
+    {
+        Mat small;
+
+        if (view.cols > sharpnessWidth)
+        {
+            resize(view, small, Size(sharpnessWidth, view.rows * sharpnessWidth / view.cols), 0, 0, INTER_AREA);
+        }
+        else
+        {
+            small = view;
+        }
+
+        Mat gray, laplacian;
+        cvtColor(small, gray, COLOR_BGR2GRAY);
+        Laplacian(gray, laplacian, CV_16S);
+
+        Scalar mean, deviation;
+        meanStdDev(laplacian, mean, deviation);
+
+        return deviation[0] * deviation[0];
+    }
+
     /**
-     * Checks if extension is .xml or .yaml.
+     * Search a frame, or a region of one, for the pattern and refine the
+     * corners.
+     * @param  view      Colour frame or region.
+     * @param  boardSize Inner corners of the board.
+     * @param  flags     findChessboardCorners flags.
+     * @param  levels    Times to halve the image before the search.
+     * @param  corners   Output corners in view coordinates.
+     * @return           If the pattern was found.
+     */
+    bool findPattern(const Mat& view, Size boardSize, int flags, int levels, vector<Point2f>& corners)
+    {
+        Mat viewGray;
+        cvtColor(view, viewGray, COLOR_BGR2GRAY);
+
+        Mat search = viewGray;
+        float scale = 1;
+
+        for (int i = 0; i < levels; i++)
+        {
+            Mat smaller;
+            pyrDown(search, smaller);
+            search = smaller;
+            scale *= 2;
+        }
+
+        bool found = findChessboardCorners(search, boardSize, corners, flags);
+
+        if (found)
+        {
+            for (Point2f& corner : corners)
+            {
+                corner *= scale;
+            }
+
+            cornerSubPix( viewGray, corners, Size(11,11), Size(-1,-1), TermCriteria(TermCriteria::EPS+TermCriteria::COUNT, 30, 0.1));
+        }
+
+        return found;
+    }
+
+    struct Detection
+    {
+        bool found;
+        double sharpness;       // Set when the frame was rejected as blurred
+        size_t frame;
+        Size size;
+        vector<Point2f> corners;
+    };
+
+    /**
+     * Checks if extension is .xml, .yaml or the binary .calib.
      * @param  input Filename.
      * @return       If extension is valid.
      */
     bool isMarkup(string input)
     {
-        return input.substr(input.length()-4, input.npos) == ".xml" || input.substr(input.length()-5, input.npos) == ".yaml";
+        auto hasExtension = [&input](const string& extension)
+        {
+            return input.length() >= extension.length()
+                && input.compare(input.length() - extension.length(), extension.length(), extension) == 0;
+        };
+
+        return hasExtension(".xml") || hasExtension(".yaml") || CalibrationFile::isBinary(input);
     }
 }
 
@@ -52,8 +171,16 @@ chessBoardFlags(CALIB_CB_ADAPTIVE_THRESH |
 calibrated(false),
 mapped(false),
 frameCount(0),
+threads(0),
+sampling({ 1, false, 0 }),
+detectionWidth(1920),
+minSharpness(0),
+convergenceInterval(5),
+convergenceTolerance(0.01),
+reprojectionError(0),
 cameraMatrix(Mat::eye(3, 3, CV_64F)),
-distCoeffs(Mat::zeros(8, 1, CV_64F))
+distCoeffs(Mat::zeros(8, 1, CV_64F)),
+lookupStep(0)
 {
 
 }
@@ -73,8 +200,16 @@ chessBoardFlags(CALIB_CB_ADAPTIVE_THRESH |
 calibrated(false),
 mapped(false),
 frameCount(0),
+threads(0),
+sampling({ 1, false, 0 }),
+detectionWidth(1920),
+minSharpness(0),
+convergenceInterval(5),
+convergenceTolerance(0.01),
+reprojectionError(0),
 cameraMatrix(Mat::eye(3, 3, CV_64F)),
-distCoeffs(Mat::zeros(8, 1, CV_64F))
+distCoeffs(Mat::zeros(8, 1, CV_64F)),
+lookupStep(0)
 {
     if (calibrationFile.size())
     {
@@ -86,8 +221,6 @@ distCoeffs(Mat::zeros(8, 1, CV_64F))
         {
             this->fromVideo(calibrationFile, 50);
         }
-
-        this->generateMaps();
     }
 }
 
@@ -106,8 +239,16 @@ chessBoardFlags(CALIB_CB_ADAPTIVE_THRESH |
 calibrated(false),
 mapped(false),
 frameCount(0),
+threads(0),
+sampling({ 1, false, 0 }),
+detectionWidth(1920),
+minSharpness(0),
+convergenceInterval(5),
+convergenceTolerance(0.01),
+reprojectionError(0),
 cameraMatrix(Mat::eye(3, 3, CV_64F)),
-distCoeffs(Mat::zeros(8, 1, CV_64F))
+distCoeffs(Mat::zeros(8, 1, CV_64F)),
+lookupStep(0)
 {
     if (calibrationFile.size())
     {
@@ -119,12 +260,10 @@ distCoeffs(Mat::zeros(8, 1, CV_64F))
         {
             this->fromFile(calibrationFile);
         }
-
-        this->generateMaps();
     }
 }
 
-bool LensCalibration::runCalibration()
+bool LensCalibration::runCalibration(int extraFlags)
 {
     vector<Mat> rvecs, tvecs;
 
@@ -142,7 +281,7 @@ bool LensCalibration::runCalibration()
 
     objectPoints.resize(this->imagePoints.size(), objectPoints[0]);
 
-    calibrateCamera(objectPoints, this->imagePoints, this->imageSize, this->cameraMatrix, this->distCoeffs, rvecs, tvecs, this->flag);
+    this->reprojectionError = calibrateCamera(objectPoints, this->imagePoints, this->imageSize, this->cameraMatrix, this->distCoeffs, rvecs, tvecs, this->flag | extraFlags);
 
     return checkRange(this->cameraMatrix) && checkRange(this->distCoeffs);
 }
@@ -157,83 +296,647 @@ bool LensCalibration::isMapped()
     return this->mapped;
 }
 
-bool LensCalibration::fromVideo(string filePath, size_t calibFrames)
+Mat LensCalibration::getCameraMatrix()
 {
-    VideoCapture inputCapture;
-    inputCapture.open(filePath);
+    return this->cameraMatrix;
+}
 
-    if (calibFrames <= 0)
+Mat LensCalibration::getDistortionCoefficients()
+{
+    return this->distCoeffs;
+}
+
+Size LensCalibration::getImageSize()
+{
+    return this->imageSize;
+}
+
+void LensCalibration::setThreads(unsigned int count)
+{
+    this->threads = count;
+}
+
+void LensCalibration::setSampling(unsigned int stride, bool seek, double minDisplacement)
+{
+    this->sampling.stride = stride > 0 ? stride : 1;
+    this->sampling.seek = seek;
+    this->sampling.minDisplacement = minDisplacement;
+}
+
+bool LensCalibration::isDiverse(const vector<Point2f>& corners) const
+{
+    if (this->sampling.minDisplacement <= 0)
     {
-        calibFrames = 50;
+        return true;
     }
 
-    if (inputCapture.isOpened())
+    for (const vector<Point2f>& accepted : this->imagePoints)
+    {
+        // The same board turned half way round is detected with its corners
+        // in reverse order, so the pose is compared both ways.
+        double displacement = 0;
+        double reversedDisplacement = 0;
+        size_t n = min(corners.size(), accepted.size());
+
+        for (size_t i = 0; i < n; i++)
+        {
+            displacement += norm(corners[i] - accepted[i]);
+            reversedDisplacement += norm(corners[i] - accepted[n - 1 - i]);
+        }
+
+        if (min(displacement, reversedDisplacement) < this->sampling.minDisplacement * corners.size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void LensCalibration::setDetectionWidth(int width)
+{
+    this->detectionWidth = width;
+}
+
+void LensCalibration::setCalibrationFlags(int flags)
+{
+    this->flag = flags;
+}
+
+int LensCalibration::getCalibrationFlags()
+{
+    return this->flag;
+}
+
+void LensCalibration::setDetectionCache(string filePath)
+{
+    this->detectionCachePath = filePath;
+}
+
+string LensCalibration::getDetectionCache()
+{
+    return this->detectionCachePath;
+}
+
+void LensCalibration::setMinSharpness(double sharpness)
+{
+    this->minSharpness = sharpness;
+}
+
+bool LensCalibration::detectPattern(const Mat& view, vector<Point2f>& corners, const vector<Point2f>& previous) const
+{
+    // Search a downscaled copy, as most frames hold no board and the full
+    // resolution search dominates on large footage. The region around the
+    // previous corners is halved as often, so the board looks the same to the
+    // detector whichever is searched.
+    int levels = 0;
+
+    for (int width = view.cols; this->detectionWidth > 0 && width > this->detectionWidth; width = (width + 1) / 2)
+    {
+        levels++;
+    }
+
+    if (!previous.empty())
+    {
+        Rect board = boundingRect(previous);
+        int padX = (int) (board.width * trackPadding) + 16;
+        int padY = (int) (board.height * trackPadding) + 16;
+        Rect region = Rect(board.x - padX, board.y - padY, board.width + 2 * padX, board.height + 2 * padY) & Rect(0, 0, view.cols, view.rows);
+
+        // A region close to the whole frame saves little and a miss would
+        // search twice.
+        if (!region.empty() && region.area() * 4 < (int) view.total() * 3)
+        {
+            if (findPattern(view(region), this->boardSize, this->chessBoardFlags, levels, corners))
+            {
+                for (Point2f& corner : corners)
+                {
+                    corner += Point2f((float) region.x, (float) region.y);
+                }
+
+                return true;
+            }
+
+            corners.clear();
+        }
+    }
+
+    return findPattern(view, this->boardSize, this->chessBoardFlags, levels, corners);
+}
+
+bool LensCalibration::acceptView(const vector<Point2f>& corners, const function<bool()>& converged)
+{
+    if (!this->isDiverse(corners))
     {
-        unsigned int frameCount = 0;
+        cout << " - found pattern, too similar to an accepted view" << endl;
+        return false;
+    }
 
-        this->imagePoints.clear();
+    cout << " - found pattern" << endl;
+    this->imagePoints.push_back(corners);
 
-        while(true)
+    return converged && converged();
+}
+
+bool LensCalibration::collectViews(function<bool(Mat&, size_t&)> nextFrame, size_t calibFrames, function<bool()> converged, vector<DetectionCache::View>* found)
+{
+    unsigned int workerCount = this->threads > 0 ? this->threads : max(thread::hardware_concurrency(), 1u);
+
+    // Sized in frames rather than chunks, as decoded frames dominate memory
+    // on high resolution footage.
+    BoundedQueue< vector<QueuedFrame> > frames(max((size_t) 1, workerCount * 2 / trackChunk));
+
+    mutex resultMutex;
+    condition_variable resultReady;
+    map<size_t, Detection> results;
+    size_t decoded = 0;
+    bool decodeDone = false;
+    atomic<bool> stop(false);
+
+    thread decoder([&]()
+    {
+        size_t index = 0;
+        vector<QueuedFrame> chunk;
+
+        while (!stop)
         {
+            // Fresh buffer for every frame as the previous one is still
+            // queued or being searched.
             Mat view;
+            size_t frame = index;
 
-            if( inputCapture.isOpened() )
+            // A decode failure ends the video early, the frames already
+            // queued are still searched.
+            try
+            {
+                if (!nextFrame(view, frame) || view.empty())
+                {
+                    break;
+                }
+            }
+            catch (const cv::Exception& e)
             {
-                inputCapture >> view;
+                cout << "Frame decoding failed at frame " << frame << ": " << e.what() << endl;
+                break;
             }
 
-            // Break conditions
-            // calibFrames need to be under 50 otherwise the program will hang
-            if( imagePoints.size() >= calibFrames || view.empty() )
+            chunk.push_back({ index, frame, view });
+            index++;
+
+            if (chunk.size() == trackChunk)
             {
-                inputCapture.release();
+                if (!frames.push(move(chunk)))
+                {
+                    break;
+                }
 
-                if(!this->imagePoints.empty())
+                chunk.clear();
+            }
+        }
+
+        if (!chunk.empty())
+        {
+            frames.push(move(chunk));
+        }
+
+        frames.close();
+
+        lock_guard<mutex> lock(resultMutex);
+        decoded = index;
+        decodeDone = true;
+        resultReady.notify_all();
+    });
+
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            vector<QueuedFrame> chunk;
+
+            while (frames.pop(chunk))
+            {
+                vector<Point2f> previous;
+
+                for (QueuedFrame& frame : chunk)
                 {
-                    runCalibration();
+                    Detection detection;
+                    detection.frame = frame.frame;
+                    detection.size = frame.view.size();
+                    detection.found = false;
+                    detection.sharpness = -1;
+
+                    try
+                    {
+                        // Blurred frames are cheap to reject, while the
+                        // detector is slow to fail on them or returns poor
+                        // corners. The board stays tracked across them.
+                        double sharpness = this->minSharpness > 0 && !stop ? measureSharpness(frame.view) : 0;
+
+                        if (sharpness < this->minSharpness)
+                        {
+                            detection.sharpness = sharpness;
+                        }
+                        else
+                        {
+                            detection.found = !stop && this->detectPattern(frame.view, detection.corners, previous);
+                            previous = detection.found ? detection.corners : vector<Point2f>();
+                        }
+                    }
+                    catch (const cv::Exception& e)
+                    {
+                        cout << "Pattern detection failed on frame " << frame.frame << ": " << e.what() << endl;
+                    }
+
+                    frame.view.release();
+
+                    lock_guard<mutex> lock(resultMutex);
+                    results[frame.index] = move(detection);
+                    resultReady.notify_all();
+                }
+            }
+        });
+    }
+
+    // Consume results in frame order, stopping at the same frame a serial
+    // pass would.
+    this->imagePoints.clear();
+    bool exhausted = false;
+
+    for (size_t next = 0; this->imagePoints.size() < calibFrames; next++)
+    {
+        unique_lock<mutex> lock(resultMutex);
+        resultReady.wait(lock, [&]() { return results.count(next) || (decodeDone && next >= decoded); });
+
+        auto it = results.find(next);
+
+        if (it == results.end())
+        {
+            exhausted = true;
+            break;
+        }
+
+        Detection detection = move(it->second);
+        results.erase(it);
+        lock.unlock();
+
+        cout << "\r" << "Frame " << detection.frame << flush;
+
+        this->imageSize = detection.size;
+
+        if (detection.sharpness >= 0)
+        {
+            cout << " - too blurred (" << detection.sharpness << ")" << endl;
+        }
+
+        if (detection.found)
+        {
+            if (found)
+            {
+                found->push_back({ (uint32_t) detection.frame, detection.corners });
+            }
+
+            if (this->acceptView(detection.corners, converged))
+            {
+                break;
+            }
+        }
+    }
+
+    stop = true;
+    frames.close();
+
+    decoder.join();
+
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    return exhausted;
+}
+
+bool LensCalibration::completeCalibration(int extraFlags, bool solve)
+{
+    if(!this->imagePoints.empty())
+    {
+        if (solve)
+        {
+            runCalibration(extraFlags);
+        }
+
+        this->frameCount = (int) this->imagePoints.size();
+        this->optimalCameraMatrix = getOptimalNewCameraMatrix(this->cameraMatrix, this->distCoeffs, this->imageSize, 1, this->imageSize, 0);
+
+        this->calibrated = true;
+        this->mapped = false;
+        this->lookupGrid.release();
+
+        return true;
+    }
+
+    this->calibrated = false;
+    this->mapped = false;
+    this->lookupGrid.release();
+
+    return false;
+}
+
+bool LensCalibration::collectVideo(string filePath, size_t calibFrames, function<bool()> converged)
+{
+    unsigned int stride = this->sampling.stride;
+    bool seek = this->sampling.seek;
+    uint64_t cacheKey = 0;
+
+    if (!this->detectionCachePath.empty())
+    {
+        // Everything that decides which corners are found, the diversity
+        // check is applied again on every replay.
+        int32_t settings[7] = { this->boardSize.width, this->boardSize.height, this->chessBoardFlags, this->detectionWidth, (int32_t) stride, seek, (int32_t) trackChunk };
+        uint64_t settingsHash = Checksum::fnv1a(settings, sizeof(settings));
+        settingsHash = Checksum::fnv1a(&this->minSharpness, sizeof(this->minSharpness), settingsHash);
+        cacheKey = DetectionCache::videoKey(filePath, settingsHash);
+
+        Size cachedSize;
+        vector<DetectionCache::View> cached;
+        bool complete = false;
+
+        if (DetectionCache::load(this->detectionCachePath, cacheKey, cachedSize, cached, complete))
+        {
+            this->imagePoints.clear();
+            this->imageSize = cachedSize;
+
+            bool stopped = false;
+
+            for (size_t i = 0; i < cached.size() && !stopped; i++)
+            {
+                cout << "\r" << "Frame " << cached[i].frame << flush;
+                stopped = this->acceptView(cached[i].corners, converged) || this->imagePoints.size() >= calibFrames;
+            }
+
+            // A cache from a search that stopped early may not reach as many
+            // views as this calibration wants.
+            if (stopped || complete)
+            {
+                cout << "Used cached detections from " << this->detectionCachePath << endl;
+                return true;
+            }
 
-                    this->frameCount = (int) this->imagePoints.size();
-                    this->optimalCameraMatrix = getOptimalNewCameraMatrix(this->cameraMatrix, this->distCoeffs, this->imageSize, 1, this->imageSize, 0);
+            cout << "Cached detections ran out, searching the video." << endl;
+        }
+    }
 
-                    this->calibrated = true;
-                    this->mapped = false;
+    VideoCapture inputCapture;
+    inputCapture.open(filePath);
 
-                    return true;
+    if (inputCapture.isOpened())
+    {
+        size_t position = 0;
+        vector<DetectionCache::View> found;
+
+        bool exhausted = this->collectViews([&](Mat& view, size_t& frame)
+        {
+            if (position > 0 && stride > 1)
+            {
+                if (seek)
+                {
+                    inputCapture.set(CAP_PROP_POS_FRAMES, (double) position);
                 }
                 else
                 {
-                    this->calibrated = false;
-                    this->mapped = false;
+                    // Grabbing skips the decode and colour conversion.
+                    for (unsigned int i = 1; i < stride; i++)
+                    {
+                        if (!inputCapture.grab())
+                        {
+                            return false;
+                        }
+                    }
                 }
+            }
 
-                return false;
+            inputCapture >> view;
+            frame = position;
+            position += stride;
+
+            return !view.empty();
+        }, calibFrames, converged, cacheKey ? &found : nullptr);
+
+        inputCapture.release();
+
+        // A read-only directory just means the video is searched next time.
+        if (cacheKey)
+        {
+            DetectionCache::store(this->detectionCachePath, cacheKey, this->imageSize, found, exhausted);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool LensCalibration::fromVideo(string filePath, size_t calibFrames)
+{
+    if (calibFrames <= 0)
+    {
+        calibFrames = 50;
+    }
+
+    return this->collectVideo(filePath, calibFrames) && this->completeCalibration();
+}
+
+bool LensCalibration::fromImages(string source, size_t calibFrames)
+{
+    vector<string> files = ImageFiles::list(source);
+
+    if (files.empty())
+    {
+        cout << "No images found: " << source << endl;
+        return false;
+    }
+
+    if (calibFrames <= 0)
+    {
+        calibFrames = files.size();
+    }
+
+    unsigned int workerCount = this->threads > 0 ? this->threads : max(thread::hardware_concurrency(), 1u);
+    workerCount = (unsigned int) min((size_t) workerCount, files.size());
+
+    // Stills are decoded and searched on the workers, as decoding dominates
+    // and, unlike a video, each file can be read independently.
+    mutex resultMutex;
+    condition_variable resultReady;
+    vector<Detection> results(files.size());
+    vector<bool> done(files.size(), false);
+    atomic<size_t> next(0);
+    atomic<bool> stop(false);
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t index = next++; index < files.size() && !stop; index = next++)
+            {
+                Detection detection;
+                detection.frame = index;
+                detection.found = false;
+                detection.sharpness = -1;
+
+                try
+                {
+                    Mat view = imread(files[index]);
+                    detection.size = view.size();
+
+                    double sharpness = this->minSharpness > 0 && !view.empty() ? measureSharpness(view) : 0;
+
+                    if (sharpness < this->minSharpness)
+                    {
+                        detection.sharpness = sharpness;
+                    }
+                    else if (!view.empty())
+                    {
+                        detection.found = this->detectPattern(view, detection.corners, vector<Point2f>());
+                    }
+                }
+                catch (const cv::Exception& e)
+                {
+                    lock_guard<mutex> lock(resultMutex);
+                    cout << "Pattern detection failed on " << files[index] << ": " << e.what() << endl;
+                }
+
+                lock_guard<mutex> lock(resultMutex);
+                results[index] = move(detection);
+                done[index] = true;
+                resultReady.notify_all();
             }
+        });
+    }
 
-            cout << "\r" << "Frame " << frameCount << flush;
-            frameCount++;
+    // Consume results in file order, so the accepted views do not depend on
+    // which worker finished first.
+    this->imagePoints.clear();
+    this->imageSize = Size();
 
-            imageSize = view.size();
+    for (size_t index = 0; index < files.size() && this->imagePoints.size() < calibFrames; index++)
+    {
+        unique_lock<mutex> lock(resultMutex);
+        resultReady.wait(lock, [&]() { return done[index]; });
 
-            vector<Point2f> pointBuf;
+        Detection detection = move(results[index]);
+        lock.unlock();
 
-            bool found = findChessboardCorners(view, this->boardSize, pointBuf, this->chessBoardFlags);
+        cout << "\r" << ImageFiles::fileName(files[index]) << flush;
 
-            if (found)
+        if (detection.size.area() <= 0)
+        {
+            cout << " - could not be read" << endl;
+        }
+        else if (detection.sharpness >= 0)
+        {
+            cout << " - too blurred (" << detection.sharpness << ")" << endl;
+        }
+        else if (this->imageSize.area() > 0 && detection.size != this->imageSize)
+        {
+            cout << " - not the same resolution as the first image" << endl;
+        }
+        else
+        {
+            this->imageSize = detection.size;
+
+            if (detection.found)
             {
-                cout << " - found pattern" << endl;
-                Mat viewGray;
-                cvtColor(view, viewGray, COLOR_BGR2GRAY);
-                cornerSubPix( viewGray, pointBuf, Size(11,11), Size(-1,-1), TermCriteria(TermCriteria::EPS+TermCriteria::COUNT, 30, 0.1));
-                this->imagePoints.push_back(pointBuf);
+                this->acceptView(detection.corners, nullptr);
             }
         }
     }
 
-    return false;
+    stop = true;
+
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    return this->completeCalibration();
+}
+
+void LensCalibration::setConvergence(unsigned int interval, double tolerance)
+{
+    this->convergenceInterval = max(interval, 1u);
+    this->convergenceTolerance = tolerance;
+}
+
+bool LensCalibration::updateFromVideo(string filePath, size_t calibFrames)
+{
+    if (!this->calibrated)
+    {
+        return this->fromVideo(filePath, calibFrames);
+    }
+
+    if (calibFrames <= 0)
+    {
+        calibFrames = 50;
+    }
+
+    Size calibratedSize = this->imageSize;
+    size_t checkedViews = 0;
+    double lastError = -1;
+
+    bool opened = this->collectVideo(filePath, calibFrames, [&]()
+    {
+        if (this->imageSize != calibratedSize || this->imagePoints.size() < checkedViews + this->convergenceInterval)
+        {
+            return false;
+        }
+
+        checkedViews = this->imagePoints.size();
+        this->runCalibration(CALIB_USE_INTRINSIC_GUESS);
+
+        cout << "Views " << checkedViews << " - reprojection error " << this->reprojectionError << endl;
+
+        bool converged = lastError >= 0 && fabs(lastError - this->reprojectionError) <= this->convergenceTolerance * lastError;
+        lastError = this->reprojectionError;
+
+        return converged;
+    });
+
+    // Without new views the current calibration is left as it was.
+    if (!opened || this->imagePoints.empty())
+    {
+        return false;
+    }
+
+    if (this->imageSize != calibratedSize)
+    {
+        // The old intrinsics belong to another resolution, so solve from
+        // scratch as fromVideo would.
+        cout << "Video size differs from the calibration, calibrating from scratch." << endl;
+        this->cameraMatrix = Mat::eye(3, 3, CV_64F);
+        this->distCoeffs = Mat::zeros(8, 1, CV_64F);
+
+        return this->completeCalibration();
+    }
+
+    // The last convergence check may already have solved every view.
+    return this->completeCalibration(CALIB_USE_INTRINSIC_GUESS, checkedViews != this->imagePoints.size());
+}
+
+double LensCalibration::getReprojectionError()
+{
+    return this->reprojectionError;
 }
 
 bool LensCalibration::fromFile(string filePath)
 {
+    if (CalibrationFile::isBinary(filePath))
+    {
+        return this->fromBinary(filePath);
+    }
+
     FileStorage fs(filePath, FileStorage::READ);
 
     if (fs.isOpened())
@@ -255,6 +958,9 @@ bool LensCalibration::fromFile(string filePath)
 
         this->calibrated = true;
         this->mapped = false;
+        this->mapCachePath = filePath + ".maps";
+        this->reprojectionError = 0;
+        this->lookupGrid.release();
 
         return true;
     }
@@ -264,6 +970,11 @@ bool LensCalibration::fromFile(string filePath)
 
 bool LensCalibration::store(string filePath)
 {
+    if (this->calibrated && CalibrationFile::isBinary(filePath))
+    {
+        return this->storeBinary(filePath);
+    }
+
     if (this->calibrated)
     {
         FileStorage fs( filePath, FileStorage::WRITE );
@@ -286,14 +997,112 @@ bool LensCalibration::store(string filePath)
     return false;
 }
 
+bool LensCalibration::fromBinary(string filePath)
+{
+    CalibrationFile file;
+
+    if (!file.read(filePath) || !file.hasSection(CalibrationFile::lensSection))
+    {
+        return false;
+    }
+
+    vector<char> payload = file.getSection(CalibrationFile::lensSection);
+    size_t offset = 0;
+
+    int32_t frames = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    Mat camera;
+    Mat optimalCamera;
+    Mat distortion;
+
+    if (!CalibrationFile::take(payload, offset, frames)
+        || !CalibrationFile::take(payload, offset, width)
+        || !CalibrationFile::take(payload, offset, height)
+        || !CalibrationFile::takeMatrix(payload, offset, camera)
+        || !CalibrationFile::takeMatrix(payload, offset, optimalCamera)
+        || !CalibrationFile::takeMatrix(payload, offset, distortion))
+    {
+        return false;
+    }
+
+    this->frameCount = frames;
+    this->imageSize = Size(width, height);
+    this->cameraMatrix = camera;
+    this->optimalCameraMatrix = optimalCamera;
+    this->distCoeffs = distortion;
+
+    this->calibrated = true;
+    this->mapped = false;
+    this->mapCachePath = filePath + ".maps";
+    this->reprojectionError = 0;
+    this->lookupGrid.release();
+
+    return true;
+}
+
+bool LensCalibration::storeBinary(string filePath)
+{
+    vector<char> payload;
+
+    CalibrationFile::put(payload, (int32_t) this->frameCount);
+    CalibrationFile::put(payload, (int32_t) this->imageSize.width);
+    CalibrationFile::put(payload, (int32_t) this->imageSize.height);
+    CalibrationFile::putMatrix(payload, this->cameraMatrix);
+    CalibrationFile::putMatrix(payload, this->optimalCameraMatrix);
+    CalibrationFile::putMatrix(payload, this->distCoeffs);
+
+    // Read first so a perspective section in the same file survives.
+    CalibrationFile file;
+    file.read(filePath);
+    file.setSection(CalibrationFile::lensSection, payload);
+
+    return file.write(filePath);
+}
+
+void LensCalibration::setMapCache(string filePath)
+{
+    this->mapCachePath = filePath;
+}
+
+string LensCalibration::getMapCache()
+{
+    return this->mapCachePath;
+}
+
 bool LensCalibration::generateMaps()
 {
+    lock_guard<mutex> lock(this->mapMutex);
+
     if(!this->mapped && this->calibrated)
     {
-        initUndistortRectifyMap(
+        uint64_t key = MapCache::key(this->cameraMatrix, this->distCoeffs, Mat(), this->imageSize);
+
+        // Old maps may point into a read-only mapping, which must not be
+        // reused as the output buffer.
+        this->calibMap1.release();
+        this->calibMap2.release();
+        this->mapStorage.reset();
+
+        if (!this->mapCachePath.empty())
+        {
+            this->mapStorage = MapCache::load(this->mapCachePath, key, this->imageSize, this->calibMap1, this->calibMap2);
+        }
+
+        if (!this->mapStorage)
+        {
+            initUndistortRectifyMap(
 					this->cameraMatrix, this->distCoeffs, Mat(),
 					this->cameraMatrix, this->imageSize,
 					CV_16SC2, this->calibMap1, this->calibMap2);
+
+            // A read-only directory just means the maps are rebuilt next time.
+            if (!this->mapCachePath.empty())
+            {
+                MapCache::store(this->mapCachePath, key, this->calibMap1, this->calibMap2);
+            }
+        }
+
         this->mapped = true;
         return true;
     }
@@ -303,7 +1112,10 @@ bool LensCalibration::generateMaps()
 
 bool LensCalibration::onImage(string imagePath, Mat& fixedImage)
 {
-    if (this->mapped)
+    // Maps are only needed for images, so they are built on first use rather
+    // than on load to keep point queries cheap. Checked again afterwards, as
+    // another thread may have built them while this one waited.
+    if (this->mapped || this->generateMaps() || this->mapped)
     {
         Mat rawImage;
 
@@ -331,10 +1143,90 @@ bool LensCalibration::onImage(string imagePath, Mat& fixedImage)
     return false;
 }
 
+bool LensCalibration::generateLookup(int step, double maxError)
+{
+    if (!this->calibrated || step <= 0 || this->imageSize.area() <= 0)
+    {
+        return false;
+    }
+
+    int cols = (this->imageSize.width + step - 1) / step;
+    int rows = (this->imageSize.height + step - 1) / step;
+
+    // Exact solutions for every grid node and every cell centre.
+    vector<Point2f> nodes;
+    vector<Point2f> centres;
+    nodes.reserve((size_t) (rows + 1) * (cols + 1));
+    centres.reserve((size_t) rows * cols);
+
+    for (int i = 0; i <= rows; i++)
+    {
+        for (int j = 0; j <= cols; j++)
+        {
+            nodes.emplace_back((float) (j * step), (float) (i * step));
+
+            if (i < rows && j < cols)
+            {
+                centres.emplace_back((float) (j * step + step * 0.5), (float) (i * step + step * 0.5));
+            }
+        }
+    }
+
+    this->onPoints(nodes.data(), nodes.data(), nodes.size());
+    this->onPoints(centres.data(), centres.data(), centres.size());
+
+    Mat grid(rows + 1, cols + 1, CV_32FC2);
+    Mat exact(rows, cols, CV_8UC1);
+    copy(nodes.begin(), nodes.end(), grid.ptr<Point2f>(0));
+
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            const Point2f* top = grid.ptr<Point2f>(i) + j;
+            const Point2f* bottom = grid.ptr<Point2f>(i + 1) + j;
+            Point2f estimate = (top[0] + top[1] + bottom[0] + bottom[1]) * 0.25f;
+
+            bool edge = i == 0 || j == 0 || i == rows - 1 || j == cols - 1;
+
+            exact.at<uchar>(i, j) = edge || norm(estimate - centres[(size_t) i * cols + j]) > maxError;
+        }
+    }
+
+    this->lookupStep = step;
+    this->lookupGrid = grid;
+    this->lookupExact = exact;
+
+    return true;
+}
+
+bool LensCalibration::hasLookup()
+{
+    return !this->lookupGrid.empty();
+}
+
 Point2f LensCalibration::onPoint(const Point2f& point)
 {
     Point2f buf(-1,-1);
 
+    if (point.x >= 0 && point.y >= 0 && !this->lookupGrid.empty())
+    {
+        float fx = point.x / this->lookupStep;
+        float fy = point.y / this->lookupStep;
+        int j = (int) fx;
+        int i = (int) fy;
+
+        if (i < this->lookupExact.rows && j < this->lookupExact.cols && !this->lookupExact.at<uchar>(i, j))
+        {
+            const Point2f* top = this->lookupGrid.ptr<Point2f>(i) + j;
+            const Point2f* bottom = this->lookupGrid.ptr<Point2f>(i + 1) + j;
+            float ax = fx - j;
+            float ay = fy - i;
+
+            return (top[0] * (1 - ax) + top[1] * ax) * (1 - ay) + (bottom[0] * (1 - ax) + bottom[1] * ax) * ay;
+        }
+    }
+
     if (point.x >= 0 && point.y >= 0)
     {
         vector<Point2f> src(1, point);
@@ -348,3 +1240,38 @@ Point2f LensCalibration::onPoint(const Point2f& point)
     return buf;
 
 }
+
+size_t LensCalibration::onPoints(const Point2f* in, Point2f* out, size_t n)
+{
+    bool valid[PointBatch::chunk];
+    size_t count = 0;
+
+    for (size_t start = 0; start < n; start += PointBatch::chunk)
+    {
+        size_t length = min(PointBatch::chunk, n - start);
+
+        for (size_t i = 0; i < length; i++)
+        {
+            valid[i] = in[start + i].x >= 0 && in[start + i].y >= 0;
+            out[start + i] = in[start + i];
+        }
+
+        Mat points((int) length, 1, CV_32FC2, out + start);
+
+        undistortPoints(points, points, this->cameraMatrix, this->distCoeffs, Mat(), this->cameraMatrix);
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (valid[i])
+            {
+                count++;
+            }
+            else
+            {
+                out[start + i] = Point2f(-1, -1);
+            }
+        }
+    }
+
+    return count;
+}
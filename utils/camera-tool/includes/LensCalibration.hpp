@@ -10,20 +10,46 @@
 #ifndef LENSCALIBRATION_H
 #define LENSCALIBRATION_H
 
+#include "MapCache.hpp"
+#include "DetectionCache.hpp"
+
 #include <opencv2/core.hpp>
 
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
 class LensCalibration
 {
+public:
+    /**
+     * Controls which video frames are searched for the pattern.
+     */
+    struct Sampling
+    {
+        unsigned int stride;        // Search every stride-th frame
+        bool seek;                  // Skip by seeking instead of grabbing frames
+        double minDisplacement;     // Minimum mean corner movement (pixels) from accepted views
+    };
+
 private:
     const cv::Size boardSize;
     const unsigned int squareSize;  // Millimeters
     const std::string pattern;
-    const int flag;
+    int flag;
     const int chessBoardFlags;
 
     bool calibrated;
-    bool mapped;
+    std::atomic<bool> mapped;
     int frameCount;
+    unsigned int threads;
+    Sampling sampling;
+    int detectionWidth;
+    double minSharpness;
+    unsigned int convergenceInterval;
+    double convergenceTolerance;
+    double reprojectionError;
     cv::Size imageSize;
     cv::Mat cameraMatrix;
     cv::Mat optimalCameraMatrix;
@@ -31,10 +57,100 @@ private:
 
     cv::Mat calibMap1;
     cv::Mat calibMap2;
+    std::shared_ptr<MappedFile> mapStorage;  // Backs the maps when loaded from the cache
+    std::string mapCachePath;
+    std::mutex mapMutex;    // Maps are built lazily from whichever thread first needs them
+    std::string detectionCachePath;
+
+    int lookupStep;
+    cv::Mat lookupGrid;     // Undistorted grid nodes (CV_32FC2)
+    cv::Mat lookupExact;    // Cells that need the exact solver (CV_8UC1)
 
     std::vector< std::vector<cv::Point2f> > imagePoints;
 
-    bool runCalibration();
+    /**
+     * Run calibrateCamera on the collected image points, storing the RMS
+     * reprojection error.
+     * @param  extraFlags Flags added to the configured calibration flags.
+     * @return            If the results are finite.
+     */
+    bool runCalibration(int extraFlags = 0);
+
+    /**
+     * Find the checkerboard corners in a frame. When the corners from the
+     * previous frame are given, the region around them is searched first and
+     * the whole frame only on a miss, as the board moves little between
+     * frames. Safe to call from multiple threads at once.
+     * @param  view     Frame to search.
+     * @param  corners  Output refined corners.
+     * @param  previous Corners found on the previous frame, may be empty.
+     * @return          If the pattern was found.
+     */
+    bool detectPattern(const cv::Mat& view, std::vector<cv::Point2f>& corners, const std::vector<cv::Point2f>& previous) const;
+
+    /**
+     * Detect the pattern on frames from a source across a pool of worker
+     * threads, while one thread decodes. Each worker searches short runs of
+     * consecutive frames so it can track the board from frame to frame.
+     * Detections are collected into imagePoints in frame order, so the result
+     * does not depend on the thread count.
+     * Views whose corners barely moved from an accepted view are rejected.
+     * @param  nextFrame   Called on the decoding thread to read the next
+     *                     frame and its source frame number, returns false
+     *                     when there are no more.
+     * @param  calibFrames Stop after this many accepted views.
+     * @param  converged   Optional check run after each accepted view, stops
+     *                     collecting early when it returns true.
+     * @param  found       Optional output of every detection considered, in
+     *                     frame order and before the diversity check.
+     * @return             If every frame of the source was searched.
+     */
+    bool collectViews(std::function<bool(cv::Mat&, size_t&)> nextFrame, size_t calibFrames, std::function<bool()> converged = nullptr, std::vector<DetectionCache::View>* found = nullptr);
+
+    /**
+     * Add a detection to imagePoints if it is diverse enough.
+     * @param  corners   Detected corners.
+     * @param  converged Optional early stop check, see collectViews.
+     * @return           If collecting should stop early.
+     */
+    bool acceptView(const std::vector<cv::Point2f>& corners, const std::function<bool()>& converged);
+
+    /**
+     * Collect views from a video file with the configured sampling. When a
+     * detection cache is set and holds detections for the video, they are
+     * used instead of searching the frames, otherwise the cache is written
+     * after the search.
+     * @param  filePath    Video file.
+     * @param  calibFrames Stop after this many accepted views.
+     * @param  converged   Optional early stop check, see collectViews.
+     * @return             If the video could be opened.
+     */
+    bool collectVideo(std::string filePath, size_t calibFrames, std::function<bool()> converged = nullptr);
+
+    /**
+     * Check if a detection is far enough from all accepted views.
+     * @param  corners Detected corners.
+     * @return         Boolean.
+     */
+    bool isDiverse(const std::vector<cv::Point2f>& corners) const;
+
+    /**
+     * Run the calibration on the collected image points and update the state.
+     * @param  extraFlags Flags added to the configured calibration flags.
+     * @param  solve      False when the current results already cover every
+     *                    collected view, only refreshing the derived state.
+     * @return            Boolean indication of success.
+     */
+    bool completeCalibration(int extraFlags = 0, bool solve = true);
+
+    /**
+     * Load or store the calibration as the lens section of a binary .calib
+     * file, keeping any other sections already in the file.
+     * @param  filePath Calibration file.
+     * @return          Boolean indication of success.
+     */
+    bool fromBinary(std::string filePath);
+    bool storeBinary(std::string filePath);
 
 public:
     LensCalibration();
@@ -53,6 +169,87 @@ public:
      */
     bool isMapped();
 
+    /**
+     * Get the camera matrix of the current calibration.
+     * @return 3x3 camera matrix.
+     */
+    cv::Mat getCameraMatrix();
+
+    /**
+     * Get the distortion coefficients of the current calibration.
+     * @return Distortion coefficients.
+     */
+    cv::Mat getDistortionCoefficients();
+
+    /**
+     * Get the image size the calibration was made at.
+     * @return Image size.
+     */
+    cv::Size getImageSize();
+
+    /**
+     * Set the number of detection threads used when calibrating.
+     * @param count Thread count, 0 uses the hardware concurrency.
+     */
+    void setThreads(unsigned int count);
+
+    /**
+     * Set how video frames are sampled when calibrating. Sampling a subset of
+     * frames and rejecting near duplicate poses gives calibrateCamera a better
+     * conditioned set of views in less time.
+     * @param stride          Search every stride-th frame (1 searches all).
+     * @param seek            Skip frames by seeking rather than grabbing,
+     *                        faster for large strides.
+     * @param minDisplacement Minimum mean corner movement in pixels from
+     *                        every accepted view (0 accepts all).
+     */
+    void setSampling(unsigned int stride, bool seek, double minDisplacement);
+
+    /**
+     * Set the widest frame the pattern search runs on. Wider frames are
+     * pyramid downscaled for the search, and the corners are then refined on
+     * the full resolution frame.
+     * @param width Maximum search width in pixels, 0 always searches at full
+     *              resolution.
+     */
+    void setDetectionWidth(int width);
+
+    /**
+     * Set the sharpness below which frames are skipped without searching for
+     * the pattern. Sharpness is the variance of the Laplacian of the frame
+     * downscaled to 640 pixels wide, and motion blurred frames score low.
+     * Rejected frames are logged with their sharpness to help pick a value.
+     * @param sharpness Minimum sharpness, 0 searches every frame.
+     */
+    void setMinSharpness(double sharpness);
+
+    /**
+     * Set the calibrateCamera flags used by later calibrations, such as to
+     * free K4/K5 or the tangential distortion.
+     * @param flags OpenCV CALIB_* flags.
+     */
+    void setCalibrationFlags(int flags);
+
+    /**
+     * Get the calibrateCamera flags.
+     * @return OpenCV CALIB_* flags.
+     */
+    int getCalibrationFlags();
+
+    /**
+     * Set the detection cache file. Calibrating from a video loads the
+     * pattern corners from it when it was written for the same video and
+     * detection settings, and writes it after searching the video otherwise.
+     * @param filePath Cache file, empty to disable the cache.
+     */
+    void setDetectionCache(std::string filePath);
+
+    /**
+     * Get the detection cache file.
+     * @return Cache file, empty if disabled.
+     */
+    std::string getDetectionCache();
+
     /**
      * Perform calibration from a video sequence containing possible
      * checkerboard patterns in different positions.
@@ -62,28 +259,115 @@ public:
      */
     bool fromVideo(std::string filePath, size_t calibFrames);
 
+    /**
+     * Perform calibration from still images of the checkerboard pattern. The
+     * images are decoded and searched across the detection threads, and the
+     * views are taken in file name order, so the result does not depend on
+     * the thread count. Every image must have the same resolution.
+     * @param  source      Directory of images or a glob pattern.
+     * @param  calibFrames Valid images to take, 0 takes all of them.
+     * @return             Boolean indication of success, false without a
+     *                     message per image if the source holds no images or
+     *                     does not exist.
+     */
+    bool fromImages(std::string source, size_t calibFrames = 0);
+
+    /**
+     * Set when an incremental update stops collecting views. Every interval
+     * accepted views the calibration is re-solved, and collection stops once
+     * the reprojection error changes by less than the tolerance.
+     * @param interval  Accepted views between checks.
+     * @param tolerance Relative change in RMS error treated as converged.
+     */
+    void setConvergence(unsigned int interval, double tolerance);
+
+    /**
+     * Refine the current calibration with views from a video, such as after a
+     * camera mount was adjusted. The current intrinsics seed the solver
+     * (CALIB_USE_INTRINSIC_GUESS) and views stop being collected once the
+     * reprojection error converges, so far fewer frames are searched than a
+     * calibration from scratch. Falls back to fromVideo when there is no
+     * calibration of the same image size to start from.
+     * @param  filePath    Video file.
+     * @param  calibFrames Maximum valid frames to take.
+     * @return             Boolean indication of success.
+     */
+    bool updateFromVideo(std::string filePath, size_t calibFrames);
+
+    /**
+     * Get the RMS reprojection error of the last calibration run.
+     * @return Error in pixels, 0 if the calibration was loaded from a file.
+     */
+    double getReprojectionError();
+
     /**
      * Load calibration from existing calibration file into the object.
-     * @param  filePath Calibration file.
+     * @param  filePath Calibration file (.xml, .yaml or .calib).
      * @return          Boolean indication of success.
      */
     bool fromFile(std::string filePath);
 
     /**
-     * Stores the currently existing calibration to a file.
+     * Stores the currently existing calibration to a file. A .calib file
+     * keeps a perspective calibration already stored in it.
      * @param  filePath Output calibration file (with valid extension).
      * @return          Boolean indication of success.
      */
     bool store(std::string filePath);
 
+    /**
+     * Set the map cache file. Maps are loaded from it when its key matches
+     * the calibration, and written to it after generating them otherwise.
+     * Loading a calibration file sets this to the file path plus ".maps".
+     * @param filePath Cache file, empty to disable the cache.
+     */
+    void setMapCache(std::string filePath);
+
+    /**
+     * Get the map cache file.
+     * @return Cache file, empty if disabled.
+     */
+    std::string getMapCache();
+
     /**
      * Create the calibration maps from current camera matrix and distortion
-     * coefficients
+     * coefficients. This is done automatically on the first onImage call, as
+     * point transforms do not require the maps. Safe to call from multiple
+     * threads, only the first call builds the maps.
      * @return Boolean indication of success.
      */
     bool generateMaps();
+
+    /**
+     * Build a coarse grid of undistorted points over the image so that onPoint
+     * can answer by bilinear interpolation instead of the iterative solver.
+     * Cells on the image border, or whose interpolation error exceeds
+     * maxError, still use the exact solver.
+     * @param  step     Grid spacing in pixels.
+     * @param  maxError Maximum interpolation error in pixels.
+     * @return          Boolean indication of success.
+     */
+    bool generateLookup(int step = 8, double maxError = 0.01);
+
+    /**
+     * Check if the lookup grid has been generated.
+     * @return Boolean.
+     */
+    bool hasLookup();
+
     bool onImage(std::string imagePath, cv::Mat& fixedImage);
     cv::Point2f onPoint(const cv::Point2f& point);
+
+    /**
+     * Remove lens distortion from a batch of points without allocating per
+     * point. Points with a negative coordinate are invalid and are output as
+     * (-1, -1).
+     * @param  in  Image space points.
+     * @param  out Transformed points, may be the same buffer as in.
+     * @param  n   Number of points.
+     * @return     Number of valid points transformed.
+     */
+    size_t onPoints(const cv::Point2f* in, cv::Point2f* out, size_t n);
 };
 
 #endif /* LENSCALIBRATION_H */
@@ -0,0 +1,290 @@
+/**
+ * MapCache.cpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ */
+
+#include "MapCache.hpp"
+#include "Checksum.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+    const char magic[8] = { 'C', 'T', 'M', 'A', 'P', 'S', 0, 0 };
+    const uint32_t version = 1;
+
+    // Map data starts on this boundary so rows stay aligned for SIMD loads.
+    const size_t alignment = 64;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t key;
+        int32_t width;
+        int32_t height;
+        int32_t type1;
+        int32_t type2;
+        uint64_t offset1;
+        uint64_t offset2;
+    };
+
+    size_t alignUp(size_t value)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    size_t matBytes(const Mat& matrix)
+    {
+        return matrix.total() * matrix.elemSize();
+    }
+
+    unsigned long processId()
+    {
+#ifdef _WIN32
+        return (unsigned long) GetCurrentProcessId();
+#else
+        return (unsigned long) getpid();
+#endif
+    }
+}
+
+MappedFile::MappedFile()
+:bytes(nullptr),
+length(0),
+#ifdef _WIN32
+file(INVALID_HANDLE_VALUE),
+mapping(nullptr)
+#else
+file(-1)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (this->bytes)
+    {
+        UnmapViewOfFile(this->bytes);
+    }
+
+    if (this->mapping)
+    {
+        CloseHandle(this->mapping);
+    }
+
+    if (this->file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(this->file);
+    }
+#else
+    if (this->bytes)
+    {
+        munmap(const_cast<unsigned char*>(this->bytes), this->length);
+    }
+
+    if (this->file >= 0)
+    {
+        close(this->file);
+    }
+#endif
+}
+
+bool MappedFile::open(string filePath)
+{
+    if (this->bytes)
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    this->file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    LARGE_INTEGER fileSize;
+
+    if (this->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        return false;
+    }
+
+    this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (!this->mapping)
+    {
+        return false;
+    }
+
+    this->bytes = static_cast<const unsigned char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    this->length = (size_t) fileSize.QuadPart;
+#else
+    this->file = ::open(filePath.c_str(), O_RDONLY);
+
+    struct stat info;
+
+    if (this->file < 0 || fstat(this->file, &info) != 0 || info.st_size == 0)
+    {
+        return false;
+    }
+
+    void* address = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, this->file, 0);
+
+    if (address == MAP_FAILED)
+    {
+        return false;
+    }
+
+    this->bytes = static_cast<const unsigned char*>(address);
+    this->length = (size_t) info.st_size;
+#endif
+
+    return this->bytes != nullptr;
+}
+
+const unsigned char* MappedFile::data() const
+{
+    return this->bytes;
+}
+
+size_t MappedFile::size() const
+{
+    return this->length;
+}
+
+uint64_t MapCache::key(const Mat& cameraMatrix, const Mat& distCoeffs, const Mat& rectification, Size imageSize)
+{
+    int size[2] = { imageSize.width, imageSize.height };
+
+    uint64_t hash = Checksum::fnv1a(size, sizeof(size));
+    hash = Checksum::fnv1a(cameraMatrix, hash);
+    hash = Checksum::fnv1a(distCoeffs, hash);
+    hash = Checksum::fnv1a(rectification, hash);
+
+    return hash;
+}
+
+shared_ptr<MappedFile> MapCache::load(string filePath, uint64_t key, Size size, Mat& map1, Mat& map2)
+{
+    shared_ptr<MappedFile> file = make_shared<MappedFile>();
+
+    if (!file->open(filePath) || file->size() < sizeof(Header))
+    {
+        return nullptr;
+    }
+
+    Header header;
+    memcpy(&header, file->data(), sizeof(Header));
+
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0
+        || header.version != version
+        || header.key != key
+        || header.width != size.width
+        || header.height != size.height
+        // A damaged header must not reach the Mat constructors below.
+        || header.type1 != CV_16SC2
+        || header.type2 != CV_16UC1
+        || header.offset1 < sizeof(Header)
+        || header.offset2 < sizeof(Header)
+        || header.offset1 % alignment != 0
+        || header.offset2 % alignment != 0
+        || header.offset1 > file->size()
+        || header.offset2 > file->size())
+    {
+        return nullptr;
+    }
+
+    // Headers only, the data stays in the mapping.
+    Mat first(size, header.type1, const_cast<unsigned char*>(file->data() + header.offset1));
+    Mat second(size, header.type2, const_cast<unsigned char*>(file->data() + header.offset2));
+
+    if (header.offset1 + matBytes(first) > file->size() || header.offset2 + matBytes(second) > file->size())
+    {
+        return nullptr;
+    }
+
+    map1 = first;
+    map2 = second;
+
+    return file;
+}
+
+bool MapCache::store(string filePath, uint64_t key, const Mat& map1, const Mat& map2)
+{
+    if (map1.empty() || map2.empty() || !map1.isContinuous() || !map2.isContinuous() || map1.size() != map2.size())
+    {
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.key = key;
+    header.width = map1.cols;
+    header.height = map1.rows;
+    header.type1 = map1.type();
+    header.type2 = map2.type();
+    header.offset1 = alignUp(sizeof(Header));
+    header.offset2 = alignUp(header.offset1 + matBytes(map1));
+
+    // Written beside the destination and renamed over it, so a reader never
+    // maps a partially written file. The temporary name is unique to this
+    // writer and created exclusively, as other processes may be storing the
+    // same cache at once.
+    static atomic<unsigned int> counter(0);
+    string tempPath = filePath + "." + to_string(processId()) + "-" + to_string(counter++) + ".tmp";
+
+    FILE* out = fopen(tempPath.c_str(), "wbx");
+
+    if (!out)
+    {
+        return false;
+    }
+
+    vector<char> padding(alignment, 0);
+    size_t gap1 = header.offset1 - sizeof(Header);
+    size_t gap2 = header.offset2 - header.offset1 - matBytes(map1);
+
+    bool written = fwrite(&header, 1, sizeof(Header), out) == sizeof(Header)
+        && fwrite(padding.data(), 1, gap1, out) == gap1
+        && fwrite(map1.data, 1, matBytes(map1), out) == matBytes(map1)
+        && fwrite(padding.data(), 1, gap2, out) == gap2
+        && fwrite(map2.data, 1, matBytes(map2), out) == matBytes(map2);
+
+    if (fclose(out) != 0 || !written)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    // Windows will not rename over an existing file.
+    remove(filePath.c_str());
+#endif
+
+    if (rename(tempPath.c_str(), filePath.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
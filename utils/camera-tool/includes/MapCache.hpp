@@ -0,0 +1,100 @@
+/**
+ * MapCache.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * This module persists remap lookup maps in a binary sidecar file next to a
+ * calibration file. Later loads memory map the file and wrap the maps in Mat
+ * headers, so no map is computed or copied and the pages are shared between
+ * processes through the page cache. Each file records a key hashed from the
+ * inputs the maps were built from, and a file with another key is ignored.
+ */
+
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * A read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile
+{
+private:
+    const unsigned char* bytes;
+    size_t length;
+
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#else
+    int file;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map a file into memory.
+     * @param  filePath File to map.
+     * @return          Boolean indication of success.
+     */
+    bool open(std::string filePath);
+
+    /**
+     * Get the start of the mapped file.
+     * @return Pointer to the first byte, null if not mapped.
+     */
+    const unsigned char* data() const;
+
+    /**
+     * Get the size of the mapped file.
+     * @return Size in bytes.
+     */
+    size_t size() const;
+};
+
+namespace MapCache
+{
+    /**
+     * Compute the key for maps built by initUndistortRectifyMap.
+     * @param  cameraMatrix    Camera matrix.
+     * @param  distCoeffs      Distortion coefficients.
+     * @param  rectification   Rectification matrix, may be empty.
+     * @param  imageSize       Map size.
+     * @return                 Key.
+     */
+    uint64_t key(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, const cv::Mat& rectification, cv::Size imageSize);
+
+    /**
+     * Load maps from a cache file. The returned mapping backs the map data and
+     * must be kept alive for as long as the maps are used.
+     * @param  filePath Cache file.
+     * @param  key      Expected key.
+     * @param  size     Expected map size.
+     * @param  map1     Output first map.
+     * @param  map2     Output second map.
+     * @return          The mapping, null if the file is missing or stale.
+     */
+    std::shared_ptr<MappedFile> load(std::string filePath, uint64_t key, cv::Size size, cv::Mat& map1, cv::Mat& map2);
+
+    /**
+     * Write maps to a cache file, replacing any existing file.
+     * @param  filePath Cache file.
+     * @param  key      Key of the maps.
+     * @param  map1     First map.
+     * @param  map2     Second map.
+     * @return          Boolean indication of success.
+     */
+    bool store(std::string filePath, uint64_t key, const cv::Mat& map1, const cv::Mat& map2);
+}
+
+#endif /* MAPCACHE_H */
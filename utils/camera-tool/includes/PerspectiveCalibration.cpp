@@ -5,8 +5,11 @@
  */
 
 #include "PerspectiveCalibration.hpp"
+#include "CalibrationFile.hpp"
+#include "PointBatch.hpp"
 
 #include <iostream>
+#include <algorithm>
 
 #include <opencv2/core/utility.hpp>
 #include <opencv2/imgproc.hpp>
@@ -86,6 +89,11 @@ double PerspectiveCalibration::getScaleFactor()
     return this->scaleFactor;
 }
 
+Mat PerspectiveCalibration::getTransform()
+{
+    return this->transform;
+}
+
 vector<Point2f> PerspectiveCalibration::estimateTransformed(vector<Point2f>& original, Point2f trueSize, Point2f translation) // width : height
 {
     vector<Point2f> buf;
@@ -152,6 +160,11 @@ bool PerspectiveCalibration::fromPoints(vector<Point2f> &original, Point2f trueS
 
 bool PerspectiveCalibration::fromFile(string filePath)
 {
+    if (CalibrationFile::isBinary(filePath))
+    {
+        return this->fromBinary(filePath);
+    }
+
     FileStorage fs(filePath, FileStorage::READ);
 
     if (fs.isOpened())
@@ -173,6 +186,11 @@ bool PerspectiveCalibration::fromFile(string filePath)
 
 bool PerspectiveCalibration::store(string filePath)
 {
+    if (this->calibrated && CalibrationFile::isBinary(filePath))
+    {
+        return this->storeBinary(filePath);
+    }
+
     if (this->calibrated)
     {
         FileStorage fs( filePath, FileStorage::WRITE );
@@ -193,6 +211,57 @@ bool PerspectiveCalibration::store(string filePath)
     return false;
 }
 
+bool PerspectiveCalibration::fromBinary(string filePath)
+{
+    CalibrationFile file;
+
+    if (!file.read(filePath) || !file.hasSection(CalibrationFile::perspectiveSection))
+    {
+        return false;
+    }
+
+    vector<char> payload = file.getSection(CalibrationFile::perspectiveSection);
+    size_t offset = 0;
+
+    double scale = 0;
+    vector<Point2f> original;
+    vector<Point2f> transformed;
+    Mat homography;
+
+    if (!CalibrationFile::take(payload, offset, scale)
+        || !CalibrationFile::takePoints(payload, offset, original)
+        || !CalibrationFile::takePoints(payload, offset, transformed)
+        || !CalibrationFile::takeMatrix(payload, offset, homography))
+    {
+        return false;
+    }
+
+    this->scaleFactor = scale;
+    this->ptsSrc = original;
+    this->ptsDst = transformed;
+    this->transform = homography;
+    this->calibrated = true;
+
+    return true;
+}
+
+bool PerspectiveCalibration::storeBinary(string filePath)
+{
+    vector<char> payload;
+
+    CalibrationFile::put(payload, this->scaleFactor);
+    CalibrationFile::putPoints(payload, this->ptsSrc);
+    CalibrationFile::putPoints(payload, this->ptsDst);
+    CalibrationFile::putMatrix(payload, this->transform);
+
+    // Read first so a lens section in the same file survives.
+    CalibrationFile file;
+    file.read(filePath);
+    file.setSection(CalibrationFile::perspectiveSection, payload);
+
+    return file.write(filePath);
+}
+
 bool PerspectiveCalibration::onImage(string imagePath, Mat& fixedImage)
 {
     if (this->calibrated)
@@ -233,3 +302,41 @@ Point2f PerspectiveCalibration::onPoint(const cv::Point2f& point)
 
     return Point2f(-1, -1);
 }
+
+size_t PerspectiveCalibration::onPoints(const Point2f* in, Point2f* out, size_t n)
+{
+    bool valid[PointBatch::chunk];
+    size_t count = 0;
+
+    for (size_t start = 0; start < n; start += PointBatch::chunk)
+    {
+        size_t length = min(PointBatch::chunk, n - start);
+
+        for (size_t i = 0; i < length; i++)
+        {
+            valid[i] = in[start + i].x >= 0 && in[start + i].y >= 0 && this->calibrated;
+            out[start + i] = in[start + i];
+        }
+
+        if (this->calibrated)
+        {
+            Mat points((int) length, 1, CV_32FC2, out + start);
+
+            perspectiveTransform(points, points, this->transform);
+        }
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (valid[i])
+            {
+                count++;
+            }
+            else
+            {
+                out[start + i] = Point2f(-1, -1);
+            }
+        }
+    }
+
+    return count;
+}
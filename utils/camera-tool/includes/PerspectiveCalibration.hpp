@@ -21,6 +21,8 @@ private:
     cv::Mat transform;
     cv::Point2i translation;
     bool performTransform();
+    bool fromBinary(std::string filePath);
+    bool storeBinary(std::string filePath);
     bool calibrated;
     double scaleFactor;
 
@@ -51,6 +53,12 @@ public:
      */
     bool setScaleFactor(double sf);
 
+    /**
+     * Get the perspective transformation matrix.
+     * @return 3x3 homography.
+     */
+    cv::Mat getTransform();
+
     /**
      * Estimate a new rectangle based on a supplied quadrilateral with the same
      * ratio as the true rectangle size in real world size.
@@ -117,13 +125,14 @@ public:
 
     /**
      * Load perspective calibration from a saved calibration file.
-     * @param  filePath Calibration file.
+     * @param  filePath Calibration file (.xml, .yaml or .calib).
      * @return          Boolean indicator of success.
      */
     bool fromFile(std::string filePath);
 
     /**
-     * Stores the calibration in the current object to a file.
+     * Stores the calibration in the current object to a file. A .calib file
+     * keeps a lens calibration already stored in it.
      * @param  filePath Calibration file.
      * @return          Boolean indicator of success.
      */
@@ -143,6 +152,17 @@ public:
      * @return       Transformed point.
      */
     cv::Point2f onPoint(const cv::Point2f& point);
+
+    /**
+     * Perform perspective calibration on a batch of points without allocating
+     * per point. Points with a negative coordinate are invalid and are output
+     * as (-1, -1).
+     * @param  in  Image space points.
+     * @param  out Transformed points, may be the same buffer as in.
+     * @param  n   Number of points.
+     * @return     Number of valid points transformed.
+     */
+    size_t onPoints(const cv::Point2f* in, cv::Point2f* out, size_t n);
 };
 
 #endif /* PERSPECTIVECALIBRATION_H */
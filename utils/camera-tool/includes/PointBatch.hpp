@@ -0,0 +1,21 @@
+/**
+ * PointBatch.hpp
+ * Created by Jerry Fan, property of The University of Auckland.
+ * Licenced under the Artistic Licence 2.0.
+ *
+ * Shared sizing for the batched point transforms.
+ */
+
+#ifndef POINT_BATCH_H
+#define POINT_BATCH_H
+
+#include <cstddef>
+
+namespace PointBatch
+{
+    // Batches are processed in fixed size chunks so per point scratch space,
+    // validity flags or narrowed copies, can live on the stack.
+    const size_t chunk = 256;
+}
+
+#endif /* POINT_BATCH_H */
@@ -7,16 +7,25 @@ Issues:
 Method argument checks need to be done before pointer checks. This means error 
 checking of arguments must occur before method body (see last three methods).
 
-Non async methods will cause node process hang-ups when running.
+Long running methods (video extraction, calibration from video, image 
+correction) run on the libuv thread pool through PromiseWorker and return a 
+Promise, as running them synchronously hangs the node process. Point 
+transforms stay synchronous.
 
 ***/
 
 #include "ICameraTool.hpp"
+#include "../includes/PointBatch.hpp"
 
 #include <memory>
 #include <iostream>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
 #include <opencv2/videoio.hpp>
 
 using namespace cv;
@@ -64,6 +73,325 @@ namespace
       Nan::To<double>(Nan::Get(pointObj, Nan::New<v8::String>("y").ToLocalChecked()).ToLocalChecked()).FromMaybe(0)
     );
   }
+
+  typedef function<size_t(const Point2f*, Point2f*, size_t)> BatchTransform;
+
+  bool isTypedPointArrays(const Nan::FunctionCallbackInfo<v8::Value>& info)
+  {
+    return info.Length() == 2
+      && ((info[0]->IsFloat32Array() && info[1]->IsFloat32Array())
+        || (info[0]->IsFloat64Array() && info[1]->IsFloat64Array()));
+  }
+
+  /**
+   * Transform interleaved xy pairs from one typed array into another of the
+   * same type, returning the number of valid points. Float32Array contents
+   * are used in place as they share the Point2f layout. Invalid points are
+   * written as (-1, -1).
+   */
+  void transformTypedArrays(const Nan::FunctionCallbackInfo<v8::Value>& info, BatchTransform transform)
+  {
+    size_t valid = 0;
+
+    if (info[0]->IsFloat32Array())
+    {
+      Nan::TypedArrayContents<float> in(info[0]);
+      Nan::TypedArrayContents<float> out(info[1]);
+
+      if (in.length() % 2 != 0 || out.length() < in.length())
+      {
+        Nan::ThrowRangeError("Input must hold xy pairs and output must be at least as long.");
+        return;
+      }
+
+      valid = transform(reinterpret_cast<const Point2f*>(*in), reinterpret_cast<Point2f*>(*out), in.length() / 2);
+    }
+    else
+    {
+      Nan::TypedArrayContents<double> in(info[0]);
+      Nan::TypedArrayContents<double> out(info[1]);
+
+      if (in.length() % 2 != 0 || out.length() < in.length())
+      {
+        Nan::ThrowRangeError("Input must hold xy pairs and output must be at least as long.");
+        return;
+      }
+
+      Point2f buffer[PointBatch::chunk];
+      size_t n = in.length() / 2;
+
+      for (size_t start = 0; start < n; start += PointBatch::chunk)
+      {
+        size_t count = min(PointBatch::chunk, n - start);
+        const double* src = *in + start * 2;
+        double* dst = *out + start * 2;
+
+        for (size_t i = 0; i < count; i++)
+        {
+          buffer[i] = Point2f((float) src[i * 2], (float) src[i * 2 + 1]);
+        }
+
+        valid += transform(buffer, buffer, count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+          dst[i * 2] = buffer[i].x;
+          dst[i * 2 + 1] = buffer[i].y;
+        }
+      }
+    }
+
+    info.GetReturnValue().Set(Nan::New<v8::Number>((double) valid));
+  }
+
+  /**
+   * Runs a task on the libuv thread pool and settles a Promise with its
+   * result. The task returns the boolean result, or sets an error message to
+   * reject instead. The optional done function runs on the main thread before
+   * resolving, for storing results on the wrapped object.
+   */
+  class PromiseWorker : public Nan::AsyncWorker
+  {
+  public:
+    PromiseWorker(function<bool(string&)> task, function<void()> done = nullptr)
+    : Nan::AsyncWorker(nullptr),
+      status(false),
+      task(task),
+      done(done)
+    {
+      v8::Local<v8::Promise::Resolver> local = v8::Promise::Resolver::New(Nan::GetCurrentContext()).ToLocalChecked();
+      this->resolver.Reset(local);
+    }
+
+    ~PromiseWorker()
+    {
+      this->resolver.Reset();
+    }
+
+    v8::Local<v8::Promise> GetPromise()
+    {
+      return Nan::New(this->resolver)->GetPromise();
+    }
+
+    void Execute()
+    {
+      string error;
+
+      // Exceptions must not escape the thread pool.
+      try
+      {
+        this->status = this->task(error);
+      }
+      catch (const exception& e)
+      {
+        error = e.what();
+      }
+
+      if (!error.empty())
+      {
+        this->SetErrorMessage(error.c_str());
+      }
+    }
+
+  protected:
+    void HandleOKCallback()
+    {
+      if (this->done)
+      {
+        this->done();
+      }
+
+      Nan::New(this->resolver)->Resolve(Nan::GetCurrentContext(), this->Result()).FromMaybe(false);
+      RunMicrotasks();
+    }
+
+    // Value the Promise resolves with, called on the main thread.
+    virtual v8::Local<v8::Value> Result()
+    {
+      return Nan::New<v8::Boolean>(this->status);
+    }
+
+    void HandleErrorCallback()
+    {
+      Nan::New(this->resolver)->Reject(Nan::GetCurrentContext(), Nan::Error(this->ErrorMessage())).FromMaybe(false);
+      RunMicrotasks();
+    }
+
+  private:
+    bool status;
+    function<bool(string&)> task;
+    function<void()> done;
+    Nan::Persistent<v8::Promise::Resolver> resolver;
+
+    // Settling outside of a JS callback does not flush the microtask queue,
+    // so the continuations would otherwise wait for unrelated activity.
+    static void RunMicrotasks()
+    {
+#if V8_MAJOR_VERSION > 7 || (V8_MAJOR_VERSION == 7 && V8_MINOR_VERSION >= 3)
+      v8::Isolate::GetCurrent()->PerformMicrotaskCheckpoint();
+#else
+      v8::Isolate::GetCurrent()->RunMicrotasks();
+#endif
+    }
+  };
+
+  /**
+   * Recycles the pixel buffers handed to JS as Buffers. Buffers come back
+   * through the Buffer free callback once JS has garbage collected them, so
+   * stepping through frames of one video reuses the same few allocations.
+   */
+  class FrameBufferPool
+  {
+  public:
+    char* acquire(size_t size)
+    {
+      lock_guard<mutex> lock(this->poolMutex);
+
+      for (size_t i = 0; i < this->pooled.size(); i++)
+      {
+        if (this->sizes[this->pooled[i]] == size)
+        {
+          char* data = this->pooled[i];
+          this->pooled.erase(this->pooled.begin() + i);
+          return data;
+        }
+      }
+
+      char* data = new char[size];
+      this->sizes[data] = size;
+
+      return data;
+    }
+
+    void release(char* data)
+    {
+      lock_guard<mutex> lock(this->poolMutex);
+
+      if (this->pooled.size() < maxPooled)
+      {
+        this->pooled.push_back(data);
+      }
+      else
+      {
+        this->sizes.erase(data);
+        delete[] data;
+      }
+    }
+
+    static void onFree(char* data, void* hint)
+    {
+      static_cast<FrameBufferPool*>(hint)->release(data);
+    }
+
+    // Never destroyed, as Buffers may still be collected during shutdown.
+    static FrameBufferPool& instance()
+    {
+      static FrameBufferPool* pool = new FrameBufferPool();
+      return *pool;
+    }
+
+  private:
+    static const size_t maxPooled = 8;
+
+    mutex poolMutex;
+    vector<char*> pooled;
+    unordered_map<char*, size_t> sizes;
+  };
+
+  /**
+   * Decodes a frame, optionally rectifies it, and converts it to RGBA
+   * directly in a pooled buffer that becomes the resolved Buffer's memory.
+   */
+  class FrameWorker : public PromiseWorker
+  {
+  public:
+    FrameWorker(shared_ptr<FrameServer> video, shared_ptr<ImageRectifier> rectifier, size_t index)
+    : PromiseWorker([this](string& error) { return this->decode(error); }),
+      video(video),
+      rectifier(rectifier),
+      index(index),
+      data(nullptr)
+    {
+
+    }
+
+    ~FrameWorker()
+    {
+      // Only still set if the Buffer was never created.
+      if (this->data)
+      {
+        FrameBufferPool::instance().release(this->data);
+      }
+    }
+
+  protected:
+    v8::Local<v8::Value> Result()
+    {
+      v8::Local<v8::Object> frame = Nan::New<v8::Object>();
+      size_t length = this->size.area() * 4;
+
+      Nan::Set(frame, Nan::New<v8::String>("width").ToLocalChecked(), Nan::New<v8::Number>(this->size.width));
+      Nan::Set(frame, Nan::New<v8::String>("height").ToLocalChecked(), Nan::New<v8::Number>(this->size.height));
+      Nan::Set(frame, Nan::New<v8::String>("data").ToLocalChecked(),
+        Nan::NewBuffer(this->data, length, FrameBufferPool::onFree, &FrameBufferPool::instance()).ToLocalChecked());
+
+      // Owned by the Buffer from here.
+      this->data = nullptr;
+
+      return frame;
+    }
+
+  private:
+    shared_ptr<FrameServer> video;
+    shared_ptr<ImageRectifier> rectifier;
+    size_t index;
+    char* data;
+    Size size;
+
+    bool decode(string& error)
+    {
+      Mat frame;
+
+      if (!this->video->getFrame(this->index, frame))
+      {
+        error = "Frame could not be decoded.";
+        return false;
+      }
+
+      if (this->rectifier)
+      {
+        Mat rectified;
+
+        if (!this->rectifier->generateMaps(frame.size()) || !this->rectifier->onImage(frame, rectified))
+        {
+          error = "Calibration does not match the video.";
+          return false;
+        }
+
+        frame = rectified;
+      }
+
+      this->size = frame.size();
+      this->data = FrameBufferPool::instance().acquire(this->size.area() * 4);
+
+      // Converted straight into the memory JS will receive.
+      Mat rgba(this->size, CV_8UC4, this->data);
+      cvtColor(frame, rgba, COLOR_BGR2RGBA);
+
+      return true;
+    }
+  };
+
+  /**
+   * Queue a worker and return its Promise, keeping the wrapped object alive
+   * until the worker completes.
+   */
+  void queuePromiseWorker(const Nan::FunctionCallbackInfo<v8::Value>& info, PromiseWorker* worker)
+  {
+    worker->SaveToPersistent("self", info.Holder());
+    info.GetReturnValue().Set(worker->GetPromise());
+    Nan::AsyncQueueWorker(worker);
+  }
 }
 
 ICameraTool::ICameraTool()
@@ -98,6 +426,9 @@ void ICameraTool::Init(v8::Local<v8::Object> exports, v8::Local<v8::Object> modu
   Nan::SetPrototypeMethod(tpl, "storePerspectiveCalibration", storePerspectiveCalibration);
   Nan::SetPrototypeMethod(tpl, "runPerspectiveCalibration", runPerspectiveCalibration);
 
+  Nan::SetPrototypeMethod(tpl, "openVideo", openVideo);
+  Nan::SetPrototypeMethod(tpl, "getFrame", getFrame);
+
   Nan::SetPrototypeMethod(tpl, "loadImageDistance", loadImageDistance);
   Nan::SetPrototypeMethod(tpl, "setImageOrigin", setImageOrigin);
   Nan::SetPrototypeMethod(tpl, "getRealCoordinates", getRealCoordinate);
@@ -134,7 +465,7 @@ NAN_METHOD(ICameraTool::isReady)
   info.GetReturnValue().Set(Nan::New<v8::Boolean>(obj->imgDst && obj->imgDst->isReady()));
 }
 
-// bool extractVideo(String src, String dst)
+// Promise<bool> extractImages(String src, String dst)
 NAN_METHOD(ICameraTool::extractImages)
 {  
   string src;
@@ -153,68 +484,42 @@ NAN_METHOD(ICameraTool::extractImages)
     return;
   }
 
-  bool status = false;
-  
   switch (overloadSignature)
   {
   case 0:
+    src = localValueToString(info[0]);
+    dst = localValueToString(info[1]);
+
+    queuePromiseWorker(info, new PromiseWorker([src, dst](string& error)
     {
-      src = localValueToString(info[0]);
-      dst = localValueToString(info[1]);
-      VideoCapture video(src);
-      if (video.isOpened())
+      FrameExtractor extractor;
+
+      bool status = extractor.extract(src, dst, [](unsigned int frameCount)
       {
-          Mat frame;
-          unsigned int frameCount = 0;
-
-          if 
-          (
-              dst.substr(dst.length() - 1, 1) != "/" ||
-              dst.substr(dst.length() - 1, 1) != "\\"
-          )
-          {
-              dst += "/";
-          }
+        cout << "\r" << "Exporting frame " << frameCount << flush;
+      });
 
-          while(true)
-          {
-              video >> frame;
-              if (!frame.empty())
-              {
-                frameCount++;
-                cout << "\r" << "Exporting frame " << frameCount << flush;
-
-                string filename = to_string(frameCount);
-                imwrite(dst + filename + ".jpg", frame);
-              }
-              else
-              {
-                break;
-              }
-              
-          } 
-
-          cout << endl;
-
-          status = true;
+      if (extractor.getFrameCount() > 0)
+      {
+        cout << endl;
       }
-      else
+      else if (!status)
       {
-        Nan::ThrowError("Video file cannot be opened.");
+        error = "Video file cannot be opened.";
       }
-    }
+
+      return status;
+    }));
     break;
   default:
     Nan::ThrowRangeError("Overload signature is not valid.");
     return;
   }
 
-  info.GetReturnValue().Set(Nan::New<v8::Boolean>(status));
-
   return;
 }
 
-// bool loadLensCalibration(String filePath, Number calibrationFrames = 50)
+// Promise<bool> loadLensCalibration(String filePath, Number calibrationFrames = 50)
 NAN_METHOD(ICameraTool::loadLensCalibration) 
 {
   ICameraTool* obj = Nan::ObjectWrap::Unwrap<ICameraTool>(info.Holder());
@@ -230,18 +535,30 @@ NAN_METHOD(ICameraTool::loadLensCalibration)
 
     if (calibFrames <= 0)
     {
-      obj->lCalib = make_shared<LensCalibration>(filePath, 50);
+      calibFrames = 50;
     }
-    else
+
+    // Built off the main thread and only swapped in once complete, so point
+    // transforms keep using the previous calibration meanwhile.
+    auto result = make_shared< shared_ptr<LensCalibration> >();
+
+    queuePromiseWorker(info, new PromiseWorker([filePath, calibFrames, result](string&)
     {
-      obj->lCalib = make_shared<LensCalibration>(filePath, calibFrames);
-    }
-    
-    obj->lCalib->generateMaps();
+      *result = make_shared<LensCalibration>(filePath, calibFrames);
 
-    bool status = obj->lCalib ? obj->lCalib->isCalibrated() && obj->lCalib->isMapped() : false;
+      return (*result)->isCalibrated();
+    }, [obj, result]()
+    {
+      obj->lCalib = *result;
+      obj->rectifier.reset();
 
-    info.GetReturnValue().Set(Nan::New<v8::Boolean>(status));
+      // The distance transform captured the old calibration, so rebuild it
+      // about the same origin rather than leave it measuring with stale maps.
+      if (obj->imgDst)
+      {
+        obj->imgDst = make_shared<ImageDistance>(obj->lCalib, obj->pCalib, obj->imgDst->getOrigin());
+      }
+    }));
   }
   else
   {
@@ -277,24 +594,36 @@ NAN_METHOD(ICameraTool::storeLensCalibration)
 }
 
 // [Overloaded]
-// bool runLensCalibration(String imagePath, String outputPath)
+// Promise<bool> runLensCalibration(String imagePath, String outputPath)
 // Object{"x" : Number, "y" : Number} runLensCalibration(Number x, Number y)
 // Object{"x" : Number, "y" : Number} runLensCalibration(Object{"x" : Number, "y" : Number} point)
+// Number runLensCalibration(Float32Array|Float64Array points, Float32Array|Float64Array output)
 NAN_METHOD(ICameraTool::runLensCalibration) 
 {
   ICameraTool* obj = Nan::ObjectWrap::Unwrap<ICameraTool>(info.Holder());
-  bool status = false;
-
   if (obj->lCalib)
   {
     if(info[0]->IsString() && info[1]->IsString())
     {
-      Mat fixedImage;
-      
-      status = obj->lCalib->onImage(localValueToString(info[0]), fixedImage) && 
-      imwrite(localValueToString(info[1]), fixedImage);
+      shared_ptr<LensCalibration> lCalib = obj->lCalib;
+      string src = localValueToString(info[0]);
+      string dst = localValueToString(info[1]);
 
-      info.GetReturnValue().Set(Nan::New<v8::Boolean>(status));
+      queuePromiseWorker(info, new PromiseWorker([lCalib, src, dst](string&)
+      {
+        Mat fixedImage;
+
+        return lCalib->onImage(src, fixedImage) && imwrite(dst, fixedImage);
+      }));
+    }
+    else if (isTypedPointArrays(info))
+    {
+      LensCalibration* lCalib = obj->lCalib.get();
+
+      transformTypedArrays(info, [lCalib](const Point2f* in, Point2f* out, size_t n)
+      {
+        return lCalib->onPoints(in, out, n);
+      });
     }
     else
     {
@@ -394,6 +723,8 @@ NAN_METHOD(ICameraTool::loadPerspectiveCalibration)
               );
           }
 
+          obj->rectifier.reset();
+
           bool status = obj->pCalib ? obj->pCalib->isCalibrated() : false;
 
           info.GetReturnValue().Set(Nan::New<v8::Boolean>(status));
@@ -413,6 +744,8 @@ NAN_METHOD(ICameraTool::loadPerspectiveCalibration)
   {
     string filePath = localValueToString(info[0]);
     obj->pCalib = make_shared<PerspectiveCalibration>(filePath);
+    obj->rectifier.reset();
+
     bool status = obj->pCalib ? obj->pCalib->isCalibrated() : false;
 
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(status));
@@ -450,25 +783,37 @@ NAN_METHOD(ICameraTool::storePerspectiveCalibration)
 }
 
 // [Overloaded]
-// bool runPerspectiveCalibration(String imagePath, String outputPath)
+// Promise<bool> runPerspectiveCalibration(String imagePath, String outputPath)
 // Object{"x" : Number, "y" : Number} runPerspectiveCalibration(Number x, Number y)
 // Object{"x" : Number, "y" : Number} runPerspectiveCalibration(Object{"x" : Number, "y" : Number} point)
+// Number runPerspectiveCalibration(Float32Array|Float64Array points, Float32Array|Float64Array output)
 NAN_METHOD(ICameraTool::runPerspectiveCalibration) 
 {
   ICameraTool* obj = Nan::ObjectWrap::Unwrap<ICameraTool>(info.Holder());
 
   if (obj->pCalib)
   {
-    bool status = false;
-
     if(info.Length() == 2 && info[0]->IsString() && info[1]->IsString())
     {
-      Mat fixedImage;
+      shared_ptr<PerspectiveCalibration> pCalib = obj->pCalib;
+      string src = localValueToString(Nan::To<v8::String>(info[0]).ToLocalChecked());
+      string dst = localValueToString(Nan::To<v8::String>(info[1]).ToLocalChecked());
 
-      status = obj->pCalib->onImage(localValueToString(Nan::To<v8::String>(info[0]).ToLocalChecked()), fixedImage) && 
-      imwrite(localValueToString(Nan::To<v8::String>(info[1]).ToLocalChecked()), fixedImage);
+      queuePromiseWorker(info, new PromiseWorker([pCalib, src, dst](string&)
+      {
+        Mat fixedImage;
 
-      info.GetReturnValue().Set(Nan::New<v8::Boolean>(status));
+        return pCalib->onImage(src, fixedImage) && imwrite(dst, fixedImage);
+      }));
+    }
+    else if (isTypedPointArrays(info))
+    {
+      PerspectiveCalibration* pCalib = obj->pCalib.get();
+
+      transformTypedArrays(info, [pCalib](const Point2f* in, Point2f* out, size_t n)
+      {
+        return pCalib->onPoints(in, out, n);
+      });
     }
     else
     {
@@ -512,6 +857,83 @@ NAN_METHOD(ICameraTool::runPerspectiveCalibration)
   }
 }
 
+// Object{"frames" : Number, "fps" : Number} openVideo(String filePath)
+NAN_METHOD(ICameraTool::openVideo)
+{
+  ICameraTool* obj = Nan::ObjectWrap::Unwrap<ICameraTool>(info.Holder());
+
+  if (info.Length() == 1 && info[0]->IsString())
+  {
+    shared_ptr<FrameServer> video = make_shared<FrameServer>();
+
+    if (video->open(localValueToString(info[0])))
+    {
+      obj->video = video;
+
+      v8::Local<v8::Object> videoInfo = Nan::New<v8::Object>();
+      Nan::Set(videoInfo, Nan::New<v8::String>("frames").ToLocalChecked(), Nan::New<v8::Number>((double) video->getFrameCount()));
+      Nan::Set(videoInfo, Nan::New<v8::String>("fps").ToLocalChecked(), Nan::New<v8::Number>(video->getFps()));
+
+      info.GetReturnValue().Set(videoInfo);
+    }
+    else
+    {
+      info.GetReturnValue().Set(Nan::New<v8::Boolean>(false));
+    }
+  }
+  else
+  {
+    Nan::ThrowTypeError("This method accepts a string type.");
+  }
+}
+
+// Promise<Object{"width" : Number, "height" : Number, "data" : Buffer}> getFrame(Number index, Boolean rectify = false)
+NAN_METHOD(ICameraTool::getFrame)
+{
+  ICameraTool* obj = Nan::ObjectWrap::Unwrap<ICameraTool>(info.Holder());
+
+  if (!(info.Length() >= 1 && info.Length() <= 2 && info[0]->IsNumber()))
+  {
+    Nan::ThrowTypeError("This method accepts a number and boolean type.");
+    return;
+  }
+
+  double index = Nan::To<double>(info[0]).FromMaybe(-1);
+  bool rectify = info.Length() == 2 && Nan::To<bool>(info[1]).FromMaybe(false);
+
+  if (!obj->video)
+  {
+    Nan::ThrowError("Video not opened.");
+    return;
+  }
+
+  if (index < 0)
+  {
+    Nan::ThrowRangeError("Frame index must not be negative.");
+    return;
+  }
+
+  shared_ptr<ImageRectifier> rectifier;
+
+  if (rectify)
+  {
+    if (!obj->rectifier)
+    {
+      obj->rectifier = make_shared<ImageRectifier>(obj->lCalib, obj->pCalib);
+    }
+
+    if (!obj->rectifier->isReady())
+    {
+      Nan::ThrowError("No calibration loaded to rectify with.");
+      return;
+    }
+
+    rectifier = obj->rectifier;
+  }
+
+  queuePromiseWorker(info, new FrameWorker(obj->video, rectifier, (size_t) index));
+}
+
 // bool loadImageDistance(Object{"x" : Number, "y" : Number} origin)
 NAN_METHOD(ICameraTool::loadImageDistance)
 {
@@ -586,7 +1008,9 @@ NAN_METHOD(ICameraTool::setImageOrigin)
   return;
 }
 
-// bool getRealCoordinate(Object{"x" : Number, "y" : Number} coordinate)
+// [Overloaded]
+// Object{"x" : Number, "y" : Number} getRealCoordinate(Object{"x" : Number, "y" : Number} coordinate)
+// Number getRealCoordinate(Float32Array|Float64Array coordinates, Float32Array|Float64Array output)
 NAN_METHOD(ICameraTool::getRealCoordinate)
 {
   ICameraTool* obj = Nan::ObjectWrap::Unwrap<ICameraTool>(info.Holder());
@@ -595,7 +1019,11 @@ NAN_METHOD(ICameraTool::getRealCoordinate)
   int overloadSignature = -1;
   v8::Local<v8::Object> pointObj;
 
-  if (info.Length() == 1 && info[0]->IsObject())
+  if (isTypedPointArrays(info))
+  {
+    overloadSignature = 1;
+  }
+  else if (info.Length() == 1 && info[0]->IsObject())
   {
     pointObj = Nan::To<v8::Object>(info[0]).ToLocalChecked();
     if (isLocalPointObject(pointObj))
@@ -615,6 +1043,7 @@ NAN_METHOD(ICameraTool::getRealCoordinate)
   }
 
   Point2f coordinate;
+  ImageDistance* imgDst = obj->imgDst.get();
 
   switch (overloadSignature)
   {
@@ -622,6 +1051,20 @@ NAN_METHOD(ICameraTool::getRealCoordinate)
     coordinate = localObjectToPoint2f(pointObj);
     break;
 
+    case 1:
+    if (imgDst)
+    {
+      transformTypedArrays(info, [imgDst](const Point2f* in, Point2f* out, size_t n)
+      {
+        return imgDst->getRealCoordinates(in, out, n);
+      });
+    }
+    else
+    {
+      Nan::ThrowError("ImageDistance object not loaded.");
+    }
+    return;
+
     default:
     Nan::ThrowRangeError("Overload signature is not valid.");
     return;
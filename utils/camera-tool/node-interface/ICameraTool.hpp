@@ -7,6 +7,9 @@
 #include "../includes/LensCalibration.hpp"
 #include "../includes/PerspectiveCalibration.hpp"
 #include "../includes/ImageDistance.hpp"
+#include "../includes/FrameExtractor.hpp"
+#include "../includes/FrameServer.hpp"
+#include "../includes/ImageRectifier.hpp"
 
 class ICameraTool : public Nan::ObjectWrap
 {
@@ -19,6 +22,8 @@ public:
     std::shared_ptr<LensCalibration> lCalib;
     std::shared_ptr<PerspectiveCalibration> pCalib;
     std::shared_ptr<ImageDistance> imgDst;
+    std::shared_ptr<FrameServer> video;
+    std::shared_ptr<ImageRectifier> rectifier;   // Rebuilt when a calibration changes
 
 private:
     explicit ICameraTool();
@@ -29,18 +34,19 @@ private:
     // bool isReady()
     static NAN_METHOD(isReady);
 
-    // bool extractVideo(String src, String dst)
+    // Promise<bool> extractImages(String src, String dst)
     static NAN_METHOD(extractImages);
 
     // LensCalibration wrapper methods
-    // bool loadLensCalibration(String filePath, Number calibrationFrames = 50)
+    // Promise<bool> loadLensCalibration(String filePath, Number calibrationFrames = 50)
     static NAN_METHOD(loadLensCalibration);
     // bool storeLensCalibration(String outputPath)
     static NAN_METHOD(storeLensCalibration);
     // [Overloaded]
-    // bool runLensCalibration(String imagePath, String outputPath)
+    // Promise<bool> runLensCalibration(String imagePath, String outputPath)
     // Object{"x" : Number, "y" : Number} runLensCalibration(Number x, Number y)
     // Object{"x" : Number, "y" : Number} runLensCalibration(Object{"x" : Number, "y" : Number} point)
+    // Number runLensCalibration(Float32Array|Float64Array points, Float32Array|Float64Array output)
     static NAN_METHOD(runLensCalibration);
 
     // PerspectiveCalibration wrapper methods
@@ -51,17 +57,26 @@ private:
     // bool storePerspectiveCalibration(String outputPath)
     static NAN_METHOD(storePerspectiveCalibration);
     // [Overloaded]
-    // bool runPerspectiveCalibration(String imagePath, String outputPath)
+    // Promise<bool> runPerspectiveCalibration(String imagePath, String outputPath)
     // Object{"x" : Number, "y" : Number} runPerspectiveCalibration(Number x, Number y)
     // Object{"x" : Number, "y" : Number} runPerspectiveCalibration(Object{"x" : Number, "y" : Number} point)
+    // Number runPerspectiveCalibration(Float32Array|Float64Array points, Float32Array|Float64Array output)
     static NAN_METHOD(runPerspectiveCalibration);
 
+    // FrameServer wrapper methods
+    // Object{"frames" : Number, "fps" : Number} openVideo(String filePath)
+    static NAN_METHOD(openVideo);
+    // Promise<Object{"width" : Number, "height" : Number, "data" : Buffer}> getFrame(Number index, Boolean rectify = false)
+    static NAN_METHOD(getFrame);
+
     // ImageDistance wrapper methods
     // bool loadImageDistance(Object{"x" : Number, "y" : Number} origin)
     static NAN_METHOD(loadImageDistance);
     // bool setImageOrigin(Object{"x" : Number, "y" : Number} origin)
     static NAN_METHOD(setImageOrigin);
-    // bool getRealCoordinate(Object{"x" : Number, "y" : Number} coordinate)
+    // [Overloaded]
+    // Object{"x" : Number, "y" : Number} getRealCoordinate(Object{"x" : Number, "y" : Number} coordinate)
+    // Number getRealCoordinate(Float32Array|Float64Array coordinates, Float32Array|Float64Array output)
     static NAN_METHOD(getRealCoordinate);
     // Object{"x" : Number, "y" : Number} getRealDistance(Object{"x" : Number, "y" : Number} from, Object{"x" : Number, "y" : Number} to)
     static NAN_METHOD(getRealDistance);